@@ -5,6 +5,7 @@
 #include "world_init.hpp"
 #include "world_system.hpp"
 #include "render_system.hpp"
+#include <algorithm>
 #include <chrono>
 #include <utils.hpp>
 
@@ -16,291 +17,414 @@ void animateEnemy(Entity& enemy_entity, vec2 velocity) {
 	if ((int)state != animation.curr_state_index) animation.setState((int)state);
 }
 
+// Bodies of the grid that may lie within radius of center, ascending so they are visited in container order.
+// The square is padded a little so rounding can't drop a body the caller's exact distance test accepts.
+void queryNeighbours(const StaticGrid& grid, vec2 center, float radius, std::vector<unsigned int>& out)
+{
+	out.clear();
+	radius += 1.f;
+	grid.query({ center.x - radius, center.y - radius, center.x + radius, center.y + radius }, out);
+	std::sort(out.begin(), out.end());
+}
+
+void AISystem::bakeNeighbourGrids()
+{
+	grid_boxes.clear();
+	for (uint i = 0; i < registry.agents.size(); i++) {
+		vec2 pos = registry.positions.get(registry.enemies.entities[i]).position;
+		grid_boxes.push_back({ pos.x, pos.y, pos.x, pos.y });
+	}
+	enemy_grid.bake(grid_boxes);
+
+	grid_boxes.clear();
+	friendly_projectiles.clear();
+	for (uint i = 0; i < registry.projectiles.size(); i++) {
+		Entity entity_p = registry.projectiles.entities[i];
+		if (registry.projectiles.components[i].hostile) continue;
+		vec2 pos = registry.positions.get(entity_p).position;
+		grid_boxes.push_back({ pos.x, pos.y, pos.x, pos.y });
+		friendly_projectiles.push_back(entity_p);
+	}
+	projectile_grid.bake(grid_boxes);
+}
+
+// Enemies updated every tick within this distance of the player, the LOD tiers beyond update every
+// AI_LOD_PERIOD[tier] ticks and keep moving with their last velocity in between
+const float AI_LOD_DISTANCE[] = { 700.f, 1400.f };
+const int AI_LOD_PERIOD[] = { 1, 4, 16 };
+// Reduced tier updates per step, the rest wait for the next step. A count rather than a time budget so
+// the same enemies update on every machine and run; the step's wall clock time is only shown by the F3 overlay.
+const unsigned int AI_REDUCED_UPDATES_PER_STEP = 128;
+
+// Half size of the enemies the flow field keeps clear of the walls
+const float FLOW_FIELD_CLEARANCE = 32.f;
+
+int lodTier(Entity entity, float player_dist, bool projectile_nearby)
+{
+	// Bosses drive their fight, and enemies need every tick to dodge
+	if (registry.bosses.has(entity) || projectile_nearby || player_dist < AI_LOD_DISTANCE[0])
+		return 0;
+	return player_dist < AI_LOD_DISTANCE[1] ? 1 : 2;
+}
+
+void AISystem::updateFlowField(vec2 target)
+{
+	// The walls only change when a level is loaded
+	if (registry.terrain.revision() != baked_terrain_revision) {
+		baked_terrain_revision = registry.terrain.revision();
+		grid_boxes.clear();
+		for (uint i = 0; i < registry.terrain.size(); i++) {
+			if (registry.terrain.components[i].moveable) continue;
+			PositionRef position = registry.positions.get(registry.terrain.entities[i]);
+			vec2 half = abs(position.scale) / 2.f;
+			grid_boxes.push_back({ position.position.x - half.x, position.position.y - half.y,
+				position.position.x + half.x, position.position.y + half.y });
+		}
+		flow_field.bake(grid_boxes, FLOW_FIELD_CLEARANCE);
+	}
+	flow_field.update(target);
+}
+
 void AISystem::step(float elapsed_ms)
 {
+	// The agents group keeps enemies with a position and velocity packed at the front of registry.enemies
 	auto& enemy_container = registry.enemies;
 	Entity player = registry.players.entities[0];
-	for (uint i = 0; i < enemy_container.size(); i++)
-	{
-		Entity entity_i = enemy_container.entities[i];
-		Velocity& vel_i = registry.velocities.get(entity_i);
-		Enemy& enemy = enemy_container.get(entity_i);
+	vec2 playerPos = registry.positions.get(player).position;
+	auto start = std::chrono::steady_clock::now();
+	// Nothing below moves enemies or the player's projectiles, the grids stay valid for the whole step
+	bakeNeighbourGrids();
+	updateFlowField(playerPos);
+	tick++;
 
-		vec2 playerPos = registry.positions.get(player).position;
+	due.clear();
+	for (uint i = 0; i < registry.agents.size(); i++) {
+		Entity entity_i = enemy_container.entities[i];
 		vec2 thisPos = registry.positions.get(entity_i).position;
-		float dist = distance(playerPos, thisPos);
-		
-		bool canSprint = enemy.stamina > 0;
-		bool isDodging = false;
-		bool isSprinting = false;
-		bool isFlanking = false;
-
-		if (registry.bosses.has(entity_i) && enemy.isAggravated) {
-			Boss& boss = registry.bosses.get(entity_i);
-			if (boss.phaseTimer > 0.f) {
-				boss.phaseTimer -= elapsed_ms;
-			} else {
-				// printf("Resolving phase %d:%d\n", boss.phase, boss.subphase);
-				switch (boss.phase) {
-					case 0:
-						if (boss.subphase == 48) {
-							boss.phase += 1;
-							boss.phaseTimer = 5000.f;
-							boss.subphase = 0;
-						} else {
-							for (int deg = boss.subphase * 2; deg < 360 + boss.subphase * 2; deg += 120) {
-								float rad = deg * 180 / 3.14;
-								vec2 direction = {cosf(rad), sinf(rad)};
-								enemyFireProjectile(entity_i, direction, 0.5f);
-							}
-							boss.subphase += 1;
-							boss.phaseTimer = 50.f;
-						}
-						break;
-					case 1:
-					case 2:
-					case 3:
-					case 4:
-					case 5:
-					case 6:
-					case 7:
-						if (boss.subphase == 10) {
-							boss.phaseTimer = 50.f;
-							if (boss.phase == 7) {
-								boss.phaseTimer = 1500.f;
-							}
-							boss.phase += 1;
-							boss.subphase = 0;
-						} else {
-							vec2 direction = {1.f, 0.f};
-							if (boss.subphase >= 5) {
-								direction = {-1.f, 0.f};
-							}
-							// vec2 position = registry.positions.get(entity_i).position;
-							vec2 adjust = {0, (boss.phase - 4) * 50};
-							vec2 subadjust = {0, ((boss.subphase % 5) + 1) * 75 + 40};
-							enemyFireProjectile(entity_i, direction, 0.5f, thisPos - adjust + subadjust);
-							enemyFireProjectile(entity_i, direction, 0.5f, thisPos - adjust - subadjust);
-							boss.subphase += 1;
-							boss.phaseTimer = 25.f;
+		queryNeighbours(projectile_grid, thisPos, 300, neighbours);
+		bool projectile_nearby = false;
+		for (unsigned int p : neighbours)
+			projectile_nearby |= distance(registry.positions.get(friendly_projectiles[p]).position, thisPos) < 300;
+
+		AILod* lod = registry.aiLods.try_get(entity_i);
+		if (lod == nullptr)
+			lod = &registry.aiLods.emplace(entity_i);
+		lod->tier = lodTier(entity_i, distance(playerPos, thisPos), projectile_nearby);
+		lod->pending_ms += elapsed_ms;
+		if (lod->tier == 0) {
+			updateEnemy(i, lod->pending_ms);
+			lod->pending_ms = 0.f;
+			continue;
+		}
+		// Staggered by entity so every tick takes an even share of a tier. Enemies held back by the cap
+		// on updates per step are overdue and go next.
+		int period = AI_LOD_PERIOD[lod->tier];
+		if ((tick + entity_i.index()) % period == 0 || lod->pending_ms > (period + 0.5f) * elapsed_ms)
+			due.push_back(i);
+	}
+
+	// The reduced tiers share the step's updates, the longest waiting first
+	std::stable_sort(due.begin(), due.end(), [&](uint a, uint b) {
+		return registry.aiLods.get(enemy_container.entities[a]).pending_ms > registry.aiLods.get(enemy_container.entities[b]).pending_ms;
+	});
+	for (unsigned int n = 0; n < due.size() && n < AI_REDUCED_UPDATES_PER_STEP; n++) {
+		AILod& lod = registry.aiLods.get(enemy_container.entities[due[n]]);
+		updateEnemy(due[n], lod.pending_ms);
+		lod.pending_ms = 0.f;
+	}
+
+	if (debugging.show_ai_lod) {
+		std::chrono::duration<float, std::milli> used = std::chrono::steady_clock::now() - start;
+		debugging.ai_step_ms = used.count();
+		debugging.ai_deferred_updates = due.size() - std::min<size_t>(due.size(), AI_REDUCED_UPDATES_PER_STEP);
+	}
+}
+
+void AISystem::updateEnemy(uint i, float elapsed_ms)
+{
+	auto& enemy_container = registry.enemies;
+	Entity player = registry.players.entities[0];
+	Entity entity_i = enemy_container.entities[i];
+	Velocity& vel_i = registry.velocities.get(entity_i);
+	Enemy& enemy = enemy_container.components[i];
+
+	vec2 playerPos = registry.positions.get(player).position;
+	vec2 thisPos = registry.positions.get(entity_i).position;
+	float dist = distance(playerPos, thisPos);
+	
+	bool canSprint = enemy.stamina > 0;
+	bool isDodging = false;
+	bool isSprinting = false;
+	bool isFlanking = false;
+
+	if (registry.bosses.has(entity_i) && enemy.isAggravated) {
+		Boss& boss = registry.bosses.get(entity_i);
+		if (boss.phaseTimer > 0.f) {
+			boss.phaseTimer -= elapsed_ms;
+		} else {
+			// printf("Resolving phase %d:%d\n", boss.phase, boss.subphase);
+			switch (boss.phase) {
+				case 0:
+					if (boss.subphase == 48) {
+						boss.phase += 1;
+						boss.phaseTimer = 5000.f;
+						boss.subphase = 0;
+					} else {
+						for (int deg = boss.subphase * 2; deg < 360 + boss.subphase * 2; deg += 120) {
+							float rad = deg * 180 / 3.14;
+							vec2 direction = {cosf(rad), sinf(rad)};
+							enemyFireProjectile(entity_i, direction, 0.5f);
 						}
-						break;
-					case 8:
-						if (boss.subphase == 25) {
-							boss.phase += 1;
+						boss.subphase += 1;
+						boss.phaseTimer = 50.f;
+					}
+					break;
+				case 1:
+				case 2:
+				case 3:
+				case 4:
+				case 5:
+				case 6:
+				case 7:
+					if (boss.subphase == 10) {
+						boss.phaseTimer = 50.f;
+						if (boss.phase == 7) {
 							boss.phaseTimer = 1500.f;
-							boss.subphase = 0;
-						} else {
-							registry.resources.get(entity_i).currentHealth += 25;
-							if (registry.resources.get(entity_i).currentHealth > registry.resources.get(entity_i).maxHealth) {
-								registry.resources.get(entity_i).currentHealth = registry.resources.get(entity_i).maxHealth;
-							}
-							boss.subphase += 1;
-							boss.phaseTimer = 50.f;
-						}
-						break;
-					case 9:
-						if (boss.subphase == 4) {
-							boss.phase += 1;
-							boss.phaseTimer = 1000.f;
-							boss.subphase = 0;
-						} else {
-							for (int deg = 0; deg < 360; deg += 10) {
-								float rad = deg * 180 / 3.14;
-								vec2 direction = {cosf(rad), sinf(rad)};
-								if (boss.subphase == 0) {
-									direction *= 200;
-								} else {
-									direction *= 150 * (boss.subphase + 1);
-								}
-								enemyFireProjectile(entity_i, - direction, 0.0f, playerPos + direction);
-							}
-							boss.subphase += 1;
-							boss.phaseTimer = 100.f;
-						}
-						break;
-					case 10:
-					case 11:
-					case 12:
-					case 13:
-					case 14:
-						for (uint i = 0; i < registry.projectiles.size(); i++) {
-							Entity thisProj = registry.projectiles.entities[i];
-							if (!registry.projectiles.get(thisProj).hostile) continue;
-							Velocity& thisProjVel = registry.velocities.get(thisProj);
-							switch (boss.phase) {
-								case 10:
-									// make sure the circle does not lead back into the boss
-									thisProjVel.velocity = normalize(playerPos - thisPos);
-									thisProjVel.velocity *= 200;
-									break;
-								case 11:
-									thisProjVel.velocity = {-150, 0};
-									break;
-								case 12:
-									thisProjVel.velocity = {0, 150};
-									break;
-								case 13:
-									thisProjVel.velocity = {150, 0};
-									break;
-								case 14:
-									thisProjVel.velocity = {0, -150};
-									break;
-							}
 						}
-						boss.phaseTimer = 750.f;
-						if (boss.phase == 10) {
-							boss.phaseTimer = 1000.f;
+						boss.phase += 1;
+						boss.subphase = 0;
+					} else {
+						vec2 direction = {1.f, 0.f};
+						if (boss.subphase >= 5) {
+							direction = {-1.f, 0.f};
 						}
+						// vec2 position = registry.positions.get(entity_i).position;
+						vec2 adjust = {0, (boss.phase - 4) * 50};
+						vec2 subadjust = {0, ((boss.subphase % 5) + 1) * 75 + 40};
+						enemyFireProjectile(entity_i, direction, 0.5f, thisPos - adjust + subadjust);
+						enemyFireProjectile(entity_i, direction, 0.5f, thisPos - adjust - subadjust);
+						boss.subphase += 1;
+						boss.phaseTimer = 25.f;
+					}
+					break;
+				case 8:
+					if (boss.subphase == 25) {
 						boss.phase += 1;
+						boss.phaseTimer = 1500.f;
 						boss.subphase = 0;
-						break;
-					case 15:
-					case 16:
-						for (uint i = 0; i < registry.projectiles.size(); i++) {
-							Entity thisProj = registry.projectiles.entities[i];
-							if (!registry.projectiles.get(thisProj).hostile) continue;
-							Velocity& thisProjVel = registry.velocities.get(thisProj);
-							Position& thisProjPos = registry.positions.get(thisProj);
-							thisProjVel.velocity = normalize(thisProjPos.position - playerPos);
-							thisProjVel.velocity *= 100;
-							if (boss.phase == 15) {
-								thisProjVel.velocity *= -0.75;
-							}
+					} else {
+						registry.resources.get(entity_i).currentHealth += 25;
+						if (registry.resources.get(entity_i).currentHealth > registry.resources.get(entity_i).maxHealth) {
+							registry.resources.get(entity_i).currentHealth = registry.resources.get(entity_i).maxHealth;
 						}
+						boss.subphase += 1;
+						boss.phaseTimer = 50.f;
+					}
+					break;
+				case 9:
+					if (boss.subphase == 4) {
 						boss.phase += 1;
 						boss.phaseTimer = 1000.f;
 						boss.subphase = 0;
-						break;
-					case 17:
-						while (0 != registry.projectiles.size()) {
-							if (registry.projectiles.entities.size() != 0) {
-								registry.remove_all_components_of_no_collision(registry.projectiles.entities[0]);
+					} else {
+						for (int deg = 0; deg < 360; deg += 10) {
+							float rad = deg * 180 / 3.14;
+							vec2 direction = {cosf(rad), sinf(rad)};
+							if (boss.subphase == 0) {
+								direction *= 200;
+							} else {
+								direction *= 150 * (boss.subphase + 1);
 							}
+							enemyFireProjectile(entity_i, - direction, 0.0f, playerPos + direction);
 						}
-						boss.phase += 1;
-						boss.phaseTimer = 1500.f;
-						boss.subphase = 0;
-						break;
-					default:
-						boss.phaseTimer = 2500.f;
-						boss.phase = 0; // reset to first phase
-						break;
-				}
+						boss.subphase += 1;
+						boss.phaseTimer = 100.f;
+					}
+					break;
+				case 10:
+				case 11:
+				case 12:
+				case 13:
+				case 14:
+					for (uint i = 0; i < registry.projectiles.size(); i++) {
+						Entity thisProj = registry.projectiles.entities[i];
+						if (!registry.projectiles.get(thisProj).hostile) continue;
+						Velocity& thisProjVel = registry.velocities.get(thisProj);
+						switch (boss.phase) {
+							case 10:
+								// make sure the circle does not lead back into the boss
+								thisProjVel.velocity = normalize(playerPos - thisPos);
+								thisProjVel.velocity *= 200;
+								break;
+							case 11:
+								thisProjVel.velocity = {-150, 0};
+								break;
+							case 12:
+								thisProjVel.velocity = {0, 150};
+								break;
+							case 13:
+								thisProjVel.velocity = {150, 0};
+								break;
+							case 14:
+								thisProjVel.velocity = {0, -150};
+								break;
+						}
+					}
+					boss.phaseTimer = 750.f;
+					if (boss.phase == 10) {
+						boss.phaseTimer = 1000.f;
+					}
+					boss.phase += 1;
+					boss.subphase = 0;
+					break;
+				case 15:
+				case 16:
+					for (uint i = 0; i < registry.projectiles.size(); i++) {
+						Entity thisProj = registry.projectiles.entities[i];
+						if (!registry.projectiles.get(thisProj).hostile) continue;
+						Velocity& thisProjVel = registry.velocities.get(thisProj);
+						PositionRef thisProjPos = registry.positions.get(thisProj);
+						thisProjVel.velocity = normalize(thisProjPos.position - playerPos);
+						thisProjVel.velocity *= 100;
+						if (boss.phase == 15) {
+							thisProjVel.velocity *= -0.75;
+						}
+					}
+					boss.phase += 1;
+					boss.phaseTimer = 1000.f;
+					boss.subphase = 0;
+					break;
+				case 17:
+					for (Entity projectile : registry.projectiles.entities) {
+						registry.commands.destroy(projectile);
+					}
+					boss.phase += 1;
+					boss.phaseTimer = 1500.f;
+					boss.subphase = 0;
+					break;
+				default:
+					boss.phaseTimer = 2500.f;
+					boss.phase = 0; // reset to first phase
+					break;
 			}
 		}
+	}
 
-		if (!registry.bosses.has(entity_i)) { // bosses never dodge
-			for (uint i = 0; i < registry.projectiles.size(); i++) {
-				Entity entity_p = registry.projectiles.entities[i];
-				Projectile& projectile = registry.projectiles.get(entity_p);
-				if (projectile.hostile) continue;
-				vec2 projectilePos = registry.positions.get(entity_p).position;
-				if (distance(projectilePos, thisPos) < 300) {
-					isDodging = true;
-					if (canSprint) {
-						isSprinting = true;
-						enemy.stamina -= elapsed_ms / 1000;
-					}
+	if (!registry.bosses.has(entity_i)) { // bosses never dodge
+		queryNeighbours(projectile_grid, thisPos, 300, neighbours);
+		for (unsigned int p : neighbours) {
+			Entity entity_p = friendly_projectiles[p];
+			vec2 projectilePos = registry.positions.get(entity_p).position;
+			if (distance(projectilePos, thisPos) < 300) {
+				isDodging = true;
+				if (canSprint) {
+					isSprinting = true;
+					enemy.stamina -= elapsed_ms / 1000;
+				}
 
-					int deg = 90;
-					// https://stackoverflow.com/questions/16177295/get-time-since-epoch-in-milliseconds-preferably-using-c11-chrono
-					unsigned long milliseconds_since_epoch = std::chrono::system_clock::now().time_since_epoch() / std::chrono::milliseconds(1);
-					if (milliseconds_since_epoch % 10000 > 5000) {
-						deg = -90;
-					}
-					float c = cosf(deg);
-					float s = sinf(deg);
-					mat2 R = {{c, s}, {-s, c}};
-
-					vec2 direction = projectilePos - thisPos;
-					direction /= length(direction);
-					direction *= isSprinting ? 300 : 50; // allow enemies to sprint even faster to dodge
-					vel_i.velocity = direction * R;
+				int deg = 90;
+				// https://stackoverflow.com/questions/16177295/get-time-since-epoch-in-milliseconds-preferably-using-c11-chrono
+				unsigned long milliseconds_since_epoch = std::chrono::system_clock::now().time_since_epoch() / std::chrono::milliseconds(1);
+				if (milliseconds_since_epoch % 10000 > 5000) {
+					deg = -90;
 				}
+				float c = cosf(deg);
+				float s = sinf(deg);
+				mat2 R = {{c, s}, {-s, c}};
+
+				vec2 direction = projectilePos - thisPos;
+				direction /= length(direction);
+				direction *= isSprinting ? 300 : 50; // allow enemies to sprint even faster to dodge
+				vel_i.velocity = direction * R;
 			}
 		}
+	}
 
-		if (enemy.mana < 1.f) {
-			enemy.mana += elapsed_ms / 1000;
-		}
+	if (enemy.mana < 1.f) {
+		enemy.mana += elapsed_ms / 1000;
+	}
 
 
-		for (uint j = 0; j < enemy_container.size(); j++) {
-			if (i == j) continue;
-			Entity entity_j = enemy_container.entities[j];
-			Enemy& enemy_j = enemy_container.get(entity_j);
-			if (distance(registry.positions.get(entity_j).position, thisPos) < 250 && registry.resources.get(entity_j).currentHealth < 80 && enemy_j.type != enemy.type) {
-				vec2 direction = registry.positions.get(entity_j).position - thisPos;
-				direction /= length(direction);
-				if (enemy.mana >= 0.75f) {
-					enemyFireProjectile(entity_i, direction);
-					enemy.mana -= 0.75f;
-				}
-			}
-			// flank the player
-			if (distance(thisPos, registry.positions.get(entity_j).position) < 100 && i > j) {
-				vec2 direction = playerPos - thisPos;
-				direction /= length(direction);
-				direction *= -50;
-				if (distance(thisPos, playerPos) > 100) {
-					vel_i.velocity = direction;
-				}
-				isFlanking = true;
+	// Both checks below are within 250 pixels
+	queryNeighbours(enemy_grid, thisPos, 250, neighbours);
+	for (unsigned int j : neighbours) {
+		if (i == j) continue;
+		Entity entity_j = enemy_container.entities[j];
+		Enemy& enemy_j = enemy_container.components[j];
+		if (distance(registry.positions.get(entity_j).position, thisPos) < 250 && registry.resources.get(entity_j).currentHealth < 80 && enemy_j.type != enemy.type) {
+			vec2 direction = registry.positions.get(entity_j).position - thisPos;
+			direction /= length(direction);
+			if (enemy.mana >= 0.75f) {
+				enemyFireProjectile(entity_i, direction);
+				enemy.mana -= 0.75f;
 			}
 		}
-
-		if (!isDodging && !isFlanking) {
-			// bosses never give chase
-			if (dist <= 350 && dist > 15 && !registry.bosses.has(entity_i) && enemy.isAggravated) {
-				if (canSprint) {
-					isSprinting = true;
-					enemy.stamina -= elapsed_ms / 1000;
-				}
-				vec2 direction = playerPos - thisPos;
-				direction /= length(direction);
-				if (enemy.mana >= 1.f) {
-					enemyFireProjectile(entity_i, direction);
-					enemy.mana -= 1.f;
-				}
-				direction *= isSprinting ? 200 : 50;
+		// flank the player
+		if (distance(thisPos, registry.positions.get(entity_j).position) < 100 && i > j) {
+			vec2 direction = playerPos - thisPos;
+			direction /= length(direction);
+			direction *= -50;
+			if (distance(thisPos, playerPos) > 100) {
 				vel_i.velocity = direction;
-			} else if (dist > 350 || !enemy.isAggravated) {
-				vel_i.velocity.y = 0;
-				if (abs(vel_i.velocity.x) != 50) {
-					vel_i.velocity.x = 50;
-				}
-				if (enemy.movementTimer <= 0.f) {
-					enemy.movementTimer = 3000.f;
-					vel_i.velocity.x = -vel_i.velocity.x;
-				} else {
-					enemy.movementTimer -= elapsed_ms;
-				}
 			}
+			isFlanking = true;
 		}
+	}
 
-		if (!isSprinting) {
-			// replenish 1 stamina per second if not sprinting
-			enemy.stamina += elapsed_ms / 1000;
+	if (!isDodging && !isFlanking) {
+		// bosses never give chase
+		if (dist <= 350 && dist > 15 && !registry.bosses.has(entity_i) && enemy.isAggravated) {
+			if (canSprint) {
+				isSprinting = true;
+				enemy.stamina -= elapsed_ms / 1000;
+			}
+			vec2 direction = playerPos - thisPos;
+			direction /= length(direction);
+			if (enemy.mana >= 1.f) {
+				enemyFireProjectile(entity_i, direction);
+				enemy.mana -= 1.f;
+			}
+			// Walk around the walls in the way, straight at the player once in its cell
+			vec2 path = flow_field.direction(thisPos);
+			if (path != vec2(0.f))
+				direction = path;
+			direction *= isSprinting ? 200 : 50;
+			vel_i.velocity = direction;
+		} else if (dist > 350 || !enemy.isAggravated) {
+			vel_i.velocity.y = 0;
+			if (abs(vel_i.velocity.x) != 50) {
+				vel_i.velocity.x = 50;
+			}
+			if (enemy.movementTimer <= 0.f) {
+				enemy.movementTimer = 3000.f;
+				vel_i.velocity.x = -vel_i.velocity.x;
+			} else {
+				enemy.movementTimer -= elapsed_ms;
+			}
 		}
+	}
 
-		animateEnemy(entity_i, vel_i.velocity);
-
-		// Decision tree:
-		// Is there a player-made projectile within 50 pixels?
-		//   Yes -> Do I have stamina?
-		//     Yes -> Try to dodge at sprint speed
-		//     No -> Try to dodge at normal speed
-		//   No -> Is player within 350 pixels?
-		//     Yes -> Do I have mana?
-		//       Yes -> Fire a projectile at the player
-		//       No -> Do I have stamina?
-		//             Yes -> Sprint towards player
-		//             No -> Move towards player
-		//     No -> Have I moved in current direction for long enough?
-		//           Yes -> Flip direction
-		//           No -> Continue moving
+	if (!isSprinting) {
+		// replenish 1 stamina per second if not sprinting
+		enemy.stamina += elapsed_ms / 1000;
 	}
+
+	animateEnemy(entity_i, vel_i.velocity);
+
+	// Decision tree:
+	// Is there a player-made projectile within 50 pixels?
+	//   Yes -> Do I have stamina?
+	//     Yes -> Try to dodge at sprint speed
+	//     No -> Try to dodge at normal speed
+	//   No -> Is player within 350 pixels?
+	//     Yes -> Do I have mana?
+	//       Yes -> Fire a projectile at the player
+	//       No -> Do I have stamina?
+	//             Yes -> Sprint towards player
+	//             No -> Move towards player
+	//     No -> Have I moved in current direction for long enough?
+	//           Yes -> Flip direction
+	//           No -> Continue moving
 }
 
 
@@ -5,6 +5,8 @@
 #include "tiny_ecs_registry.hpp"
 #include "common.hpp"
 #include "render_system.hpp"
+#include "broadphase.hpp"
+#include "flow_field.hpp"
 
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 // DON'T WORRY ABOUT THIS CLASS UNTIL ASSIGNMENT 3
@@ -20,4 +22,24 @@ private:
 	bool enemyFireProjectile(Entity& enemy, vec2 direction, float speedMultiplier);
 	bool enemyFireProjectile(Entity& enemy, vec2 direction, float speedMultiplier, vec2 position);
 	RenderSystem* renderer;
+
+	// Runs the decision tree of agent i, elapsed_ms is the time since its last update. Which agents are
+	// updated in a step depends on their LOD tier, see step.
+	void updateEnemy(uint i, float elapsed_ms);
+	unsigned int tick = 0;
+	std::vector<unsigned int> due; // agents of the reduced LOD tiers whose update is due
+
+	// Rebuilt every step from the positions at its start. Body i of enemy_grid is agent i, body i of
+	// projectile_grid is friendly_projectiles[i] (the player's projectiles, the ones enemies dodge).
+	StaticGrid enemy_grid{ 256.f };
+	StaticGrid projectile_grid{ 256.f };
+	std::vector<AABB> grid_boxes;
+	std::vector<Entity> friendly_projectiles;
+	std::vector<unsigned int> neighbours;
+	void bakeNeighbourGrids();
+
+	// Paths to the player around the static terrain, rebaked whenever the terrain container changed
+	FlowField flow_field;
+	uint64_t baked_terrain_revision = ~0ull;
+	void updateFlowField(vec2 target);
 };
\ No newline at end of file
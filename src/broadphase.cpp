@@ -0,0 +1,203 @@
+// internal
+#include "broadphase.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BROADPHASE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+	int cell_coord(float x, float cell_size)
+	{
+		return (int)std::floor(x / cell_size);
+	}
+
+	uint64_t cell_key(int x, int y)
+	{
+		return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+	}
+
+	// The cell reporting an overlapping pair: the one holding the top-left corner of the overlap,
+	// which both boxes cover. Pairs sharing several cells are found once this way.
+	uint64_t owning_cell(const AABB& a, const AABB& b, float cell_size)
+	{
+		return cell_key(cell_coord(std::max(a.left, b.left), cell_size), cell_coord(std::max(a.top, b.top), cell_size));
+	}
+
+	// Writes every candidate index and only advances past the overlapping ones, so there is no branch per box
+	size_t find_overlaps_scalar(const AABB& box, const AABBArray& boxes, size_t begin, size_t end, unsigned int* out)
+	{
+		size_t count = 0;
+		for (size_t i = begin; i < end; i++) {
+			out[count] = (unsigned int)i;
+			count += box.left <= boxes.right[i] && box.right >= boxes.left[i] &&
+				box.bottom >= boxes.top[i] && box.top <= boxes.bottom[i];
+		}
+		return count;
+	}
+}
+
+void find_overlaps(const AABB& box, const AABBArray& boxes, size_t begin, size_t end, std::vector<unsigned int>& hits)
+{
+	assert(begin <= end && end <= boxes.size());
+	size_t first = hits.size();
+	hits.resize(first + (end - begin));
+	unsigned int* out = hits.data() + first;
+	size_t count = 0;
+	size_t i = begin;
+
+#if defined(__AVX__)
+	const __m256 left = _mm256_set1_ps(box.left), top = _mm256_set1_ps(box.top);
+	const __m256 right = _mm256_set1_ps(box.right), bottom = _mm256_set1_ps(box.bottom);
+	for (; i + 8 <= end; i += 8) {
+		__m256 hit = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(left, _mm256_loadu_ps(&boxes.right[i]), _CMP_LE_OQ),
+				_mm256_cmp_ps(right, _mm256_loadu_ps(&boxes.left[i]), _CMP_GE_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(bottom, _mm256_loadu_ps(&boxes.top[i]), _CMP_GE_OQ),
+				_mm256_cmp_ps(top, _mm256_loadu_ps(&boxes.bottom[i]), _CMP_LE_OQ)));
+		int mask = _mm256_movemask_ps(hit);
+		if (mask == 0)
+			continue;
+		for (int lane = 0; lane < 8; lane++) {
+			out[count] = (unsigned int)(i + lane);
+			count += (mask >> lane) & 1;
+		}
+	}
+#elif defined(BROADPHASE_SSE2)
+	const __m128 left = _mm_set1_ps(box.left), top = _mm_set1_ps(box.top);
+	const __m128 right = _mm_set1_ps(box.right), bottom = _mm_set1_ps(box.bottom);
+	for (; i + 4 <= end; i += 4) {
+		__m128 hit = _mm_and_ps(
+			_mm_and_ps(_mm_cmple_ps(left, _mm_loadu_ps(&boxes.right[i])), _mm_cmpge_ps(right, _mm_loadu_ps(&boxes.left[i]))),
+			_mm_and_ps(_mm_cmpge_ps(bottom, _mm_loadu_ps(&boxes.top[i])), _mm_cmple_ps(top, _mm_loadu_ps(&boxes.bottom[i]))));
+		int mask = _mm_movemask_ps(hit);
+		if (mask == 0)
+			continue;
+		for (int lane = 0; lane < 4; lane++) {
+			out[count] = (unsigned int)(i + lane);
+			count += (mask >> lane) & 1;
+		}
+	}
+#endif
+	count += find_overlaps_scalar(box, boxes, i, end, out + count);
+	hits.resize(first + count);
+}
+
+void SpatialHash::build(const std::vector<AABB>& boxes)
+{
+	entries.clear();
+	oversized.clear();
+	overlapping.clear();
+
+	for (unsigned int body = 0; body < boxes.size(); body++) {
+		const AABB& box = boxes[body];
+		int x0 = cell_coord(box.left, cell_size), x1 = cell_coord(box.right, cell_size);
+		int y0 = cell_coord(box.top, cell_size), y1 = cell_coord(box.bottom, cell_size);
+		if ((int64_t)(x1 - x0 + 1) * (y1 - y0 + 1) > MAX_CELLS_PER_BODY) {
+			oversized.push_back(body);
+			continue;
+		}
+		for (int x = x0; x <= x1; x++)
+			for (int y = y0; y <= y1; y++)
+				entries.push_back({ cell_key(x, y), body });
+	}
+
+	// Group the entries by cell, bodies ascending within a cell
+	std::sort(entries.begin(), entries.end());
+	entry_boxes.clear();
+	for (const GridEntry& entry : entries)
+		entry_boxes.push_back(boxes[entry.body]);
+
+	for (size_t begin = 0; begin < entries.size();) {
+		size_t end = begin + 1;
+		while (end < entries.size() && entries[end].cell == entries[begin].cell)
+			end++;
+		for (size_t i = begin; i + 1 < end; i++) {
+			const AABB& a = boxes[entries[i].body];
+			hits.clear();
+			find_overlaps(a, entry_boxes, i + 1, end, hits);
+			for (unsigned int j : hits) {
+				const AABB& b = boxes[entries[j].body];
+				if (owning_cell(a, b, cell_size) != entries[begin].cell)
+					continue;
+				overlapping.emplace_back(entries[i].body, entries[j].body);
+			}
+		}
+		begin = end;
+	}
+
+	// Oversized bodies against everything, a pair of two oversized bodies is tested by the lower one
+	if (!oversized.empty()) {
+		all_boxes.clear();
+		for (const AABB& box : boxes)
+			all_boxes.push_back(box);
+	}
+	for (unsigned int big : oversized) {
+		hits.clear();
+		find_overlaps(boxes[big], all_boxes, 0, boxes.size(), hits);
+		for (unsigned int body : hits) {
+			if (body == big || (body < big && std::binary_search(oversized.begin(), oversized.end(), body)))
+				continue;
+			overlapping.emplace_back(std::min(big, body), std::max(big, body));
+		}
+	}
+
+	// The order of the nested loop over all pairs, so collisions are reported in the same order
+	std::sort(overlapping.begin(), overlapping.end());
+}
+
+void StaticGrid::bake(const std::vector<AABB>& boxes)
+{
+	this->boxes = boxes;
+	entries.clear();
+	for (unsigned int body = 0; body < boxes.size(); body++) {
+		const AABB& box = boxes[body];
+		int x0 = cell_coord(box.left, cell_size), x1 = cell_coord(box.right, cell_size);
+		int y0 = cell_coord(box.top, cell_size), y1 = cell_coord(box.bottom, cell_size);
+		for (int x = x0; x <= x1; x++)
+			for (int y = y0; y <= y1; y++)
+				entries.push_back({ cell_key(x, y), body });
+	}
+	std::sort(entries.begin(), entries.end());
+	entry_boxes.clear();
+	for (const GridEntry& entry : entries)
+		entry_boxes.push_back(boxes[entry.body]);
+}
+
+void StaticGrid::query(const AABB& box, std::vector<unsigned int>& out) const
+{
+	if (entries.empty())
+		return;
+	int x0 = cell_coord(box.left, cell_size), x1 = cell_coord(box.right, cell_size);
+	int y0 = cell_coord(box.top, cell_size), y1 = cell_coord(box.bottom, cell_size);
+	for (int x = x0; x <= x1; x++) {
+		// The cells of a column are contiguous in key order, except that negative rows sort after the
+		// others. Each run of rows is found with a single search.
+		int runs[2][2] = { { y0, std::min(y1, -1) }, { std::max(y0, 0), y1 } };
+		for (auto& run : runs) {
+			if (run[0] > run[1])
+				continue;
+			uint64_t first_cell = cell_key(x, run[0]), last_cell = cell_key(x, run[1]);
+			size_t begin = std::lower_bound(entries.begin(), entries.end(), GridEntry{ first_cell, 0 }) - entries.begin();
+			size_t end = begin;
+			while (end < entries.size() && entries[end].cell <= last_cell)
+				end++;
+
+			// Entries overlapping the box are appended to out, then replaced by their body in place
+			size_t first = out.size(), kept = first;
+			find_overlaps(box, entry_boxes, begin, end, out);
+			for (size_t i = first; i < out.size(); i++) {
+				const GridEntry& entry = entries[out[i]];
+				if (owning_cell(box, boxes[entry.body], cell_size) == entry.cell)
+					out[kept++] = entry.body;
+			}
+			out.resize(kept);
+		}
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+// Axis-aligned box in world coordinates, top < bottom as y grows downwards
+struct AABB {
+	float left, top, right, bottom;
+};
+
+// Same test as the physics system always used, edges that touch count as overlapping
+inline bool overlaps(const AABB& a, const AABB& b)
+{
+	return a.left <= b.right && a.right >= b.left && a.bottom >= b.top && a.top <= b.bottom;
+}
+
+// Boxes stored as separate arrays of edges so several of them can be tested in one SIMD compare
+struct AABBArray {
+	std::vector<float> left, top, right, bottom;
+
+	size_t size() const { return left.size(); }
+	void clear() { left.clear(); top.clear(); right.clear(); bottom.clear(); }
+	void push_back(const AABB& box) {
+		left.push_back(box.left);
+		top.push_back(box.top);
+		right.push_back(box.right);
+		bottom.push_back(box.bottom);
+	}
+};
+
+// Append the indices in [begin, end) of the boxes overlapping 'box' to hits, in ascending order.
+// Tests 8 boxes at a time with AVX, 4 with SSE2 and one by one otherwise.
+void find_overlaps(const AABB& box, const AABBArray& boxes, size_t begin, size_t end, std::vector<unsigned int>& hits);
+
+// A body entered in a grid cell, the cell packs the integer cell coordinates
+struct GridEntry {
+	uint64_t cell;
+	unsigned int body;
+	bool operator<(const GridEntry& other) const {
+		return cell < other.cell || (cell == other.cell && body < other.body);
+	}
+};
+
+// Uniform grid broadphase. Every body is entered in the cells its box covers, and only bodies sharing a
+// cell are tested against each other. Bodies covering too many cells (long walls) are kept aside and
+// tested against everything. Rebuilt every tick, the buffers keep their capacity so that doesn't allocate.
+class SpatialHash
+{
+public:
+	explicit SpatialHash(float cell_size = 128.f) : cell_size(cell_size) {}
+
+	// Find the overlapping pairs among boxes, bodies are identified by their index
+	void build(const std::vector<AABB>& boxes);
+
+	// Overlapping pairs (i < j) sorted like the nested i/j loop would find them
+	const std::vector<std::pair<unsigned int, unsigned int>>& pairs() const { return overlapping; }
+
+private:
+	// Bodies covering more cells than this go to the oversized list
+	static const int MAX_CELLS_PER_BODY = 64;
+
+	float cell_size;
+	std::vector<GridEntry> entries;
+	AABBArray entry_boxes; // box of entries[i], so the bodies of a cell are contiguous
+	AABBArray all_boxes;
+	std::vector<unsigned int> oversized;
+	std::vector<unsigned int> hits;
+	std::vector<std::pair<unsigned int, unsigned int>> overlapping;
+};
+
+// Grid of bodies that don't move while it is queried, baked once (e.g. per level, or per tick for the
+// AI's neighbour queries) and then only queried. Unlike the SpatialHash it has no size limit per body,
+// a wall along a whole corridor is entered in every cell.
+class StaticGrid
+{
+public:
+	explicit StaticGrid(float cell_size = 128.f) : cell_size(cell_size) {}
+
+	// Replace the contents, bodies are identified by their index in boxes
+	void bake(const std::vector<AABB>& boxes);
+
+	// Append the bodies whose boxes overlap 'box' to out, each at most once
+	void query(const AABB& box, std::vector<unsigned int>& out) const;
+
+	size_t size() const { return boxes.size(); }
+
+private:
+	float cell_size;
+	std::vector<AABB> boxes;
+	std::vector<GridEntry> entries;
+	AABBArray entry_boxes; // box of entries[i]
+};
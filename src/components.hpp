@@ -139,18 +139,13 @@ struct PowerUpIndicator
 
 };
 
-struct Follower
+// Attaches an entity to a parent: its position is the parent's plus offset. Parents can be attached
+// themselves, depth is the number of links up to the root and keeps the container sorted parents first.
+struct Parent
 {
-	Entity owner;
-	float y_offset = 0.f;
-	float x_offset = 0.f;
-};
-
-struct SecondaryFollower
-{
-	Entity owner;
-	float y_offset = 0.f;
-	float x_offset = 0.f;
+	Entity entity;
+	vec2 offset = { 0.f, 0.f };
+	unsigned int depth = 1;
 };
 
 // Structure to store projectile entities
@@ -176,6 +171,39 @@ struct Position {
 	vec2 prev_position = { 0.f, 0.f };
 };
 
+// Positions are stored as a structure of arrays (see soa_layout), the registry hands out a PositionRef
+// to the members of one entity in place of a Position&
+struct PositionRef {
+	vec2& position;
+	float& angle;
+	vec2& scale;
+	vec2& prev_position;
+
+	PositionRef(vec2& position, float& angle, vec2& scale, vec2& prev_position)
+		: position(position), angle(angle), scale(scale), prev_position(prev_position) {}
+	// Copies refer to the same entry, assignment copies the values over
+	PositionRef(const PositionRef&) = default;
+
+	operator Position() const { return { position, angle, scale, prev_position }; }
+	PositionRef& operator=(const Position& p) {
+		position = p.position;
+		angle = p.angle;
+		scale = p.scale;
+		prev_position = p.prev_position;
+		return *this;
+	}
+	PositionRef& operator=(const PositionRef& p) { return *this = Position(p); }
+};
+
+// The integration, the broadphase boxes and the shadows each stream over a few of the members
+template <>
+struct soa_layout<Position>
+{
+	using fields = type_list<vec2, float, vec2, vec2>;
+	using reference = PositionRef;
+	enum Field { POSITION, ANGLE, SCALE, PREV_POSITION };
+};
+
 // Data relevant to velocity of entities
 struct Velocity {
 	vec2 velocity = { 0.f, 0.f };
@@ -185,6 +213,18 @@ struct Floor {
 
 };
 
+// A body at rest, not integrated and kept out of the broadphase until something wakes it (see PhysicsSystem)
+struct Sleeping {
+
+};
+
+// How often the AI updates an enemy: tier 0 every tick, higher tiers less often (see AISystem)
+struct AILod {
+	int tier = 0;
+	// Time since the enemy was last updated, handed to its next update
+	float pending_ms = 0.f;
+};
+
 
 // Data relevant to direction of entities
 typedef enum {
@@ -225,15 +265,43 @@ struct Terrain
 
 // Component container that marks an entity as being collidable
 // Will be: players, enemies, terrain, projectiles, etc.
+// Collision categories, every collidable is in one and lists the categories it collides with in its mask
+enum CollisionCategory : uint32_t {
+	CATEGORY_PLAYER = 1 << 0,
+	CATEGORY_ENEMY = 1 << 1,
+	CATEGORY_BOSS = 1 << 2,
+	CATEGORY_TERRAIN = 1 << 3,
+	CATEGORY_OBSTACLE = 1 << 4,
+	CATEGORY_PLAYER_PROJECTILE = 1 << 5,
+	CATEGORY_ENEMY_PROJECTILE = 1 << 6,
+	CATEGORY_POWER_UP_BLOCK = 1 << 7,
+	CATEGORY_EXIT_DOOR = 1 << 8,
+	CATEGORY_PICKUP = 1 << 9, // health packs and life orbs
+	CATEGORY_LOST_SOUL = 1 << 10,
+	CATEGORY_ALL = ~0u
+};
+
 struct Collidable
 {
-
+	uint32_t category = CATEGORY_ALL;
+	uint32_t mask = CATEGORY_ALL;
+	// Fast movers are swept from prev_position to position, so they can't pass through thin walls in one tick
+	bool continuous = false;
+
+	// A pair is tested when either side wants to collide with the other
+	bool collidesWith(const Collidable& other) const {
+		return (category & other.mask) != 0 || (other.category & mask) != 0;
+	}
 };
 
 // Data structure for toggling debug mode
 struct Debug {
 	bool in_debug_mode = 0;
 	bool in_freeze_mode = 0;
+	bool show_ai_lod = 0; // label every enemy with its AI LOD tier, toggled with F3
+	// Profiling shown with the LOD tiers, measured only while they are shown
+	float ai_step_ms = 0.f; // wall clock time of the last AISystem::step
+	size_t ai_deferred_updates = 0; // reduced tier updates it left for the next step
 };
 extern Debug debugging;
 
@@ -254,25 +322,25 @@ struct DebugComponent
 // A timer that will be associated to an entity having an invulnerability period to damage
 struct InvulnerableTimer
 {
-	float timer_ms = 1000.f;
+	float timer_ms = 500.f;
 };
 
 // A timer that will be associated to an entity dying
 struct DeathTimer
 {
-	float timer_ms = 2700.f;
+	float timer_ms = 1350.f;
 };
 
 // Timer that signifies level change
 struct WinTimer
 {
-	float timer_ms = 3600.f;
+	float timer_ms = 1800.f;
 	bool changedLevel = false;
 };
 
 struct WeaknessTimer
 {
-	float timer_ms = 3000.f;
+	float timer_ms = 1500.f;
 	ElementType weakTo = ElementType::FIRE;
 };
 
@@ -493,10 +561,27 @@ enum class SPRITE_SHEET_DATA_ID {
 };
 const int sprite_sheet_count = (int)SPRITE_SHEET_DATA_ID::SPRITE_SHEET_COUNT;
 
+// Draw order of the main pass, back to front (there is no depth test). Floors, shadows and the UI are
+// drawn in their own passes, their layers only document where they sit.
+enum class RENDER_LAYER {
+	FLOOR = 0,
+	SHADOW,
+	TERRAIN,
+	ITEM,
+	AURA,
+	ENEMY,
+	PROJECTILE,
+	PLAYER,
+	UI
+};
+
 struct RenderRequest {
 	TEXTURE_ASSET_ID used_texture = TEXTURE_ASSET_ID::TEXTURE_COUNT;
 	EFFECT_ASSET_ID used_effect = EFFECT_ASSET_ID::EFFECT_COUNT;
 	GEOMETRY_BUFFER_ID used_geometry = GEOMETRY_BUFFER_ID::GEOMETRY_COUNT;
+	// Lower layers are drawn first. Within a layer requests are batched by effect, texture and
+	// geometry (see RenderSystem::draw), so overlapping sprites that must stack need their own layer.
+	RENDER_LAYER layer = RENDER_LAYER::ENEMY;
 };
 
 // One for each sprite sheet to indicate the states
@@ -0,0 +1,37 @@
+// internal
+#include "fixed_timestep.hpp"
+
+#include <assert.h>
+#include <cmath>
+
+FixedTimestep::FixedTimestep(float tick_ms, int max_ticks_per_frame)
+{
+	setTickMs(tick_ms);
+	setMaxTicksPerFrame(max_ticks_per_frame);
+}
+
+void FixedTimestep::setTickMs(float tick_ms)
+{
+	assert(tick_ms > 0.f);
+	this->tick_ms = tick_ms;
+}
+
+void FixedTimestep::setMaxTicksPerFrame(int ticks)
+{
+	assert(ticks > 0);
+	max_ticks_per_frame = ticks;
+}
+
+int FixedTimestep::advance(float elapsed_ms)
+{
+	accumulated_ms += elapsed_ms;
+	int ticks = 0;
+	while (accumulated_ms >= tick_ms && ticks < max_ticks_per_frame) {
+		accumulated_ms -= tick_ms;
+		ticks++;
+	}
+	// Too far behind, drop whole ticks rather than spiral into ever longer frames
+	if (accumulated_ms >= tick_ms)
+		accumulated_ms = std::fmod(accumulated_ms, tick_ms);
+	return ticks;
+}
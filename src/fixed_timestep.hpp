@@ -0,0 +1,33 @@
+#pragma once
+
+// Consumes the frame time in ticks of a fixed length, the simulation runs once per tick and the
+// rendering interpolates in between. The tick length and the catch-up limit can be changed while
+// the game runs, the time already accumulated is then consumed in ticks of the new length.
+class FixedTimestep
+{
+public:
+	explicit FixedTimestep(float tick_ms = 1000.f / 60.f, int max_ticks_per_frame = 5);
+
+	float tickMs() const { return tick_ms; }
+	void setTickMs(float tick_ms);
+	// e.g. setRate(30.f) for 30 ticks per second
+	void setRate(float ticks_per_second) { setTickMs(1000.f / ticks_per_second); }
+
+	// Ticks simulated per frame at most, a slower frame drops the rest and the game slows down
+	int maxTicksPerFrame() const { return max_ticks_per_frame; }
+	void setMaxTicksPerFrame(int ticks);
+
+	// Add the time of a frame and return the number of ticks to simulate for it
+	int advance(float elapsed_ms);
+
+	// How far the leftover time is into the next tick, below 1 after advance()
+	float alpha() const { return accumulated_ms / tick_ms; }
+
+	// Drop the leftover time, e.g. while the game is paused
+	void reset() { accumulated_ms = 0.f; }
+
+private:
+	float tick_ms;
+	int max_ticks_per_frame;
+	float accumulated_ms = 0.f;
+};
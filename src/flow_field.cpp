@@ -0,0 +1,127 @@
+// internal
+#include "flow_field.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	const unsigned int UNREACHED = ~0u;
+
+	// The 8 neighbours, straight ones first
+	const int step_x[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	const int step_y[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+	const unsigned int step_cost[8] = { 2, 2, 2, 2, 3, 3, 3, 3 };
+}
+
+void FlowField::bake(const std::vector<AABB>& walls, float clearance)
+{
+	target_cell = -1;
+	if (walls.empty()) {
+		columns = rows = 0;
+		return;
+	}
+
+	// The levels are closed by their walls, the grid spans them plus a free border
+	AABB bounds = walls[0];
+	for (const AABB& wall : walls) {
+		bounds.left = std::min(bounds.left, wall.left);
+		bounds.top = std::min(bounds.top, wall.top);
+		bounds.right = std::max(bounds.right, wall.right);
+		bounds.bottom = std::max(bounds.bottom, wall.bottom);
+	}
+	origin = { bounds.left - cell_size, bounds.top - cell_size };
+	columns = (int)std::ceil((bounds.right - bounds.left) / cell_size) + 2;
+	rows = (int)std::ceil((bounds.bottom - bounds.top) / cell_size) + 2;
+
+	blocked.assign((size_t)columns * rows, 0);
+	for (const AABB& wall : walls) {
+		// Cells whose centre lies in the wall grown by clearance
+		int x0 = std::max(0, (int)std::ceil((wall.left - clearance - origin.x) / cell_size - 0.5f));
+		int x1 = std::min(columns - 1, (int)std::floor((wall.right + clearance - origin.x) / cell_size - 0.5f));
+		int y0 = std::max(0, (int)std::ceil((wall.top - clearance - origin.y) / cell_size - 0.5f));
+		int y1 = std::min(rows - 1, (int)std::floor((wall.bottom + clearance - origin.y) / cell_size - 0.5f));
+		for (int y = y0; y <= y1; y++)
+			for (int x = x0; x <= x1; x++)
+				blocked[y * columns + x] = 1;
+	}
+}
+
+int FlowField::cellAt(vec2 pos) const
+{
+	int x = (int)std::floor((pos.x - origin.x) / cell_size);
+	int y = (int)std::floor((pos.y - origin.y) / cell_size);
+	if (x < 0 || y < 0 || x >= columns || y >= rows)
+		return -1;
+	return y * columns + x;
+}
+
+void FlowField::update(vec2 target)
+{
+	int cell = cellAt(target);
+	if (cell == target_cell)
+		return;
+	target_cell = cell;
+	cost.assign((size_t)columns * rows, UNREACHED);
+	flow.assign((size_t)columns * rows, vec2(0.f));
+	if (cell < 0)
+		return;
+
+	// Dijkstra from the target, which counts as free even when it hugs a wall. Steps cost 2 or 3, so
+	// a circular queue of 4 buckets replaces the heap: what a cell reaches never lands in its own bucket.
+	cost[cell] = 0;
+	buckets[0].push_back(cell);
+	size_t pending = 1;
+	for (unsigned int current = 0; pending > 0; current++) {
+		std::vector<int>& bucket = buckets[current % 4];
+		for (int top : bucket) {
+			pending--;
+			if (cost[top] != current)
+				continue;
+			int x = top % columns, y = top / columns;
+			for (int n = 0; n < 8; n++) {
+				int nx = x + step_x[n], ny = y + step_y[n];
+				if (nx < 0 || ny < 0 || nx >= columns || ny >= rows)
+					continue;
+				int next = ny * columns + nx;
+				// Diagonal steps can't cut the corner of a blocked cell
+				if (blocked[next] || (n >= 4 && (blocked[y * columns + nx] || blocked[ny * columns + x])))
+					continue;
+				unsigned int next_cost = current + step_cost[n];
+				if (next_cost < cost[next]) {
+					cost[next] = next_cost;
+					buckets[next_cost % 4].push_back(next);
+					pending++;
+				}
+			}
+		}
+		bucket.clear();
+	}
+
+	// Every cell points at its cheapest neighbour. Blocked cells the target was reached from (an agent
+	// pushed into the clearance of a wall) get a direction too, so they walk back out.
+	for (int y = 0; y < rows; y++) {
+		for (int x = 0; x < columns; x++) {
+			int current = y * columns + x;
+			unsigned int best = blocked[current] ? UNREACHED : cost[current];
+			for (int n = 0; n < 8; n++) {
+				int nx = x + step_x[n], ny = y + step_y[n];
+				if (nx < 0 || ny < 0 || nx >= columns || ny >= rows)
+					continue;
+				int next = ny * columns + nx;
+				if (cost[next] < best && (n < 4 || (!blocked[y * columns + nx] && !blocked[ny * columns + x]))) {
+					best = cost[next];
+					flow[current] = normalize(vec2((float)step_x[n], (float)step_y[n]));
+				}
+			}
+		}
+	}
+	flow[cell] = vec2(0.f);
+}
+
+vec2 FlowField::direction(vec2 pos) const
+{
+	int cell = cellAt(pos);
+	if (cell < 0 || target_cell < 0)
+		return vec2(0.f);
+	return flow[cell];
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "common.hpp"
+#include "broadphase.hpp"
+
+#include <vector>
+
+// Shortest paths from every cell of a grid to one target, shared by all the agents walking towards it.
+// Walls are baked into an occupancy grid, then a search from the target's cell stores in every free cell
+// the direction of its next step. Agents sample that direction in O(1), whatever their number.
+class FlowField
+{
+public:
+	explicit FlowField(float cell_size = 32.f) : cell_size(cell_size) {}
+
+	// Replace the occupancy grid. Cells whose centre is within clearance of a wall are blocked, so an
+	// agent of that half size following the field doesn't scrape along the walls.
+	void bake(const std::vector<AABB>& walls, float clearance);
+
+	// Search from the cell holding target. Nothing is recomputed while the target stays in that cell.
+	void update(vec2 target);
+
+	// Unit direction to walk from pos, zero if pos is in the target's cell (head straight for it),
+	// off the grid or cut off from the target
+	vec2 direction(vec2 pos) const;
+
+private:
+	float cell_size;
+	vec2 origin = { 0.f, 0.f }; // top left corner of the grid
+	int columns = 0, rows = 0;
+	std::vector<unsigned char> blocked;
+	int target_cell = -1;
+
+	std::vector<unsigned int> cost; // to the target, in units of 1/2 straight step (diagonals cost 3)
+	std::vector<vec2> flow;
+	std::vector<int> buckets[4]; // cells to expand, by cost modulo 4 (steps cost less than 4)
+
+	int cellAt(vec2 pos) const;
+};
@@ -163,4 +163,18 @@ public:
 	}
 
 	int getLifeOrbPiece() { return life_orb_piece; }
+
+	// Capacity hints, upper estimates of what is alive at once in this level. The registry reserves
+	// them up front so spawning never reallocates the component arrays in the middle of a fight.
+	size_t getProjectileBudget() {
+		// a boss keeps up to two rings of 144 projectiles on screen (AI phases 0 and 9)
+		if (is_boss_level || !bosses_attr.empty()) return 2 * 144;
+		return 8 * (enemies_attr.size() + 1);
+	}
+
+	size_t getEntityBudget() {
+		// enemies come with a health bar and a shadow, the player with its bars and power up display
+		return floor_attrs.size() + terrains_attr.size() + texts.size() + health_packs_pos.size() + obstacle_attrs.size() +
+			2 * lost_souls_attr.size() + 3 * (enemies_attr.size() + bosses_attr.size()) + 32 + getProjectileBudget();
+	}
 };
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include "world_system.hpp"
 #include "ai_system.hpp"
 #include "ui_system.hpp"
+#include "fixed_timestep.hpp"
 
 using Clock = std::chrono::high_resolution_clock;
 
@@ -45,7 +46,8 @@ int main()
 	world_system.init(&render_system, curr_level);
 	ai_system.init(&render_system);
 
-	// variable timestep loop
+	// fixed timestep loop, the frame time is consumed in ticks of timestep.tickMs() (60 Hz by default)
+	FixedTimestep timestep;
 	auto t = Clock::now();
 	while (!world_system.is_over()) {
 		// Processes system messages, if this wasn't present the window would become unresponsive
@@ -58,7 +60,7 @@ int main()
 		auto now = Clock::now();
 		float elapsed_ms =
 			(float)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
-		if (elapsed_ms > 100) elapsed_ms = 100; // guarantee at least 10 ticks per second
+		if (elapsed_ms > 100) elapsed_ms = 100; // don't try to catch up on stalls (e.g. dragging the window)
 		t = now;
 
 		// handles what UI elements to show
@@ -78,12 +80,23 @@ int main()
 			else {
 				ui_system->setTutorialFlag(false);
 			}
-			world_system.step(elapsed_ms);
-			physics_system.step(elapsed_ms);
-			ai_system.step(elapsed_ms);
-			world_system.step(elapsed_ms);
 
-			world_system.handle_collisions();
+			int ticks = timestep.advance(elapsed_ms);
+			for (int tick = 0; tick < ticks; tick++) {
+				float tick_ms = timestep.tickMs();
+				physics_system.beginTick();
+				world_system.step(tick_ms);
+				physics_system.step(tick_ms);
+				ai_system.step(tick_ms);
+
+				world_system.handle_collisions();
+				physics_system.propagateTransforms();
+				registry.flush_commands();
+				physics_system.endTick();
+			}
+		}
+		else {
+			timestep.reset();
 		}
 
 		if (ui_system->getState() == QUIT) {
@@ -91,7 +104,9 @@ int main()
 		}
 
 		render_system.animation_step(elapsed_ms);
-		render_system.draw();
+		// Paused states draw the latest positions, playing interpolates from the last tick
+		bool playing = ui_system->getState() == PLAY_GAME;
+		render_system.draw(playing ? timestep.alpha() : 1.f);
 	}
 
 	return EXIT_SUCCESS;
@@ -0,0 +1,144 @@
+// internal
+#include "physics_kernels.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+	const float pi_f = 3.14159265358979323846f;
+
+	// Minimax polynomial of atan(a) on [0, 1]
+	const float atan_c1 = 0.99997726f;
+	const float atan_c3 = -0.33262347f;
+	const float atan_c5 = 0.19354346f;
+	const float atan_c7 = -0.11643287f;
+	const float atan_c9 = 0.05265332f;
+	const float atan_c11 = -0.01172120f;
+
+	float atan_unit(float a)
+	{
+		float s = a * a;
+		return a * (atan_c1 + s * (atan_c3 + s * (atan_c5 + s * (atan_c7 + s * (atan_c9 + s * atan_c11)))));
+	}
+
+	void shadow_scalar(ShadowBatch& batch, size_t i, float light_x, float light_y,
+		float inv_width, float inv_height, float light_radius_sq, float max_dist, float inv_max_dist)
+	{
+		float screen_dx = (batch.shadow_x[i] - light_x) * inv_width;
+		float screen_dy = (batch.shadow_y[i] - light_y) * inv_height;
+		batch.active[i] = screen_dx * screen_dx + screen_dy * screen_dy > light_radius_sq ? 0.f : 1.f;
+
+		float dx = batch.owner_x[i] - light_x, dy = batch.owner_y[i] - light_y;
+		float dist = std::sqrt(dx * dx + dy * dy);
+		// cos and sin of the direction away from the light, (1, 0) when on top of it like atan2(0, 0)
+		float cos_angle = dist > 0.f ? dx / dist : 1.f;
+		float sin_angle = dist > 0.f ? dy / dist : 0.f;
+		float shrink = (max_dist - dist) * inv_max_dist;
+
+		batch.angle[i] = approx_atan2(dy, dx) + pi_f / 2;
+		batch.scale_x[i] = batch.owner_scale_x[i] * shrink;
+		batch.scale_y[i] = batch.owner_scale_y[i] * shrink * 1.5f;
+		batch.x[i] = batch.owner_x[i] + cos_angle * (batch.scale_y[i] / 2);
+		batch.y[i] = batch.owner_y[i] + batch.owner_scale_y[i] / 2 + batch.scale_y[i] / 2 * sin_angle;
+	}
+}
+
+void integrate_kernel(vec2* position, const Velocity* velocities, const float* awake, float step_seconds, size_t n)
+{
+	for (size_t i = 0; i < n; i++) {
+		float scale = step_seconds * awake[i];
+		position[i].x += scale * velocities[i].velocity.x;
+		position[i].y += scale * velocities[i].velocity.y;
+	}
+}
+
+float approx_atan2(float y, float x)
+{
+	float ax = std::fabs(x), ay = std::fabs(y);
+	float big = ax > ay ? ax : ay, small = ax > ay ? ay : ax;
+	float r = atan_unit(big > 0.f ? small / big : 0.f);
+	if (ay > ax) r = pi_f / 2 - r;
+	if (x < 0.f) r = pi_f - r;
+	if (y < 0.f) r = -r;
+	return r;
+}
+
+void ShadowBatch::clear()
+{
+	for (std::vector<float>* values : { &owner_x, &owner_y, &owner_scale_x, &owner_scale_y, &shadow_x, &shadow_y })
+		values->clear();
+}
+
+void ShadowBatch::push_back(float owner_x, float owner_y, float owner_scale_x, float owner_scale_y, float shadow_x, float shadow_y)
+{
+	this->owner_x.push_back(owner_x);
+	this->owner_y.push_back(owner_y);
+	this->owner_scale_x.push_back(owner_scale_x);
+	this->owner_scale_y.push_back(owner_scale_y);
+	this->shadow_x.push_back(shadow_x);
+	this->shadow_y.push_back(shadow_y);
+}
+
+void shadow_kernel(ShadowBatch& batch, float light_x, float light_y,
+	float window_width, float window_height, float light_radius, float max_dist)
+{
+	const size_t n = batch.size();
+	for (std::vector<float>* values : { &batch.x, &batch.y, &batch.angle, &batch.scale_x, &batch.scale_y, &batch.active })
+		values->resize(n);
+	const float inv_width = 1.f / window_width, inv_height = 1.f / window_height;
+	const float light_radius_sq = light_radius * light_radius, inv_max_dist = 1.f / max_dist;
+
+	size_t i = 0;
+#ifdef KERNELS_SSE2
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), half = _mm_set1_ps(0.5f);
+	const __m128 half_pi = _mm_set1_ps(pi_f / 2), full_pi = _mm_set1_ps(pi_f);
+	const __m128 sign_bit = _mm_set1_ps(-0.f);
+	const __m128 lx = _mm_set1_ps(light_x), ly = _mm_set1_ps(light_y);
+	for (; i + 4 <= n; i += 4) {
+		__m128 screen_dx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&batch.shadow_x[i]), lx), _mm_set1_ps(inv_width));
+		__m128 screen_dy = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&batch.shadow_y[i]), ly), _mm_set1_ps(inv_height));
+		__m128 screen_sq = _mm_add_ps(_mm_mul_ps(screen_dx, screen_dx), _mm_mul_ps(screen_dy, screen_dy));
+		_mm_storeu_ps(&batch.active[i], _mm_andnot_ps(_mm_cmpgt_ps(screen_sq, _mm_set1_ps(light_radius_sq)), one));
+
+		__m128 owner_x = _mm_loadu_ps(&batch.owner_x[i]), owner_y = _mm_loadu_ps(&batch.owner_y[i]);
+		__m128 dx = _mm_sub_ps(owner_x, lx), dy = _mm_sub_ps(owner_y, ly);
+		__m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+		__m128 away = _mm_cmpgt_ps(dist, zero);
+		__m128 cos_angle = _mm_or_ps(_mm_and_ps(away, _mm_div_ps(dx, dist)), _mm_andnot_ps(away, one));
+		__m128 sin_angle = _mm_and_ps(away, _mm_div_ps(dy, dist));
+		__m128 shrink = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max_dist), dist), _mm_set1_ps(inv_max_dist));
+
+		// atan2 by octant, as in approx_atan2
+		__m128 ax = _mm_andnot_ps(sign_bit, dx), ay = _mm_andnot_ps(sign_bit, dy);
+		__m128 big = _mm_max_ps(ax, ay), small = _mm_min_ps(ax, ay);
+		__m128 a = _mm_and_ps(_mm_cmpgt_ps(big, zero), _mm_div_ps(small, big));
+		__m128 s = _mm_mul_ps(a, a);
+		__m128 poly = _mm_add_ps(_mm_set1_ps(atan_c9), _mm_mul_ps(s, _mm_set1_ps(atan_c11)));
+		poly = _mm_add_ps(_mm_set1_ps(atan_c7), _mm_mul_ps(s, poly));
+		poly = _mm_add_ps(_mm_set1_ps(atan_c5), _mm_mul_ps(s, poly));
+		poly = _mm_add_ps(_mm_set1_ps(atan_c3), _mm_mul_ps(s, poly));
+		poly = _mm_add_ps(_mm_set1_ps(atan_c1), _mm_mul_ps(s, poly));
+		__m128 r = _mm_mul_ps(a, poly);
+		__m128 steep = _mm_cmpgt_ps(ay, ax);
+		r = _mm_or_ps(_mm_and_ps(steep, _mm_sub_ps(half_pi, r)), _mm_andnot_ps(steep, r));
+		__m128 left = _mm_cmplt_ps(dx, zero);
+		r = _mm_or_ps(_mm_and_ps(left, _mm_sub_ps(full_pi, r)), _mm_andnot_ps(left, r));
+		r = _mm_xor_ps(r, _mm_and_ps(_mm_cmplt_ps(dy, zero), sign_bit));
+		_mm_storeu_ps(&batch.angle[i], _mm_add_ps(r, half_pi));
+
+		__m128 owner_scale_y = _mm_loadu_ps(&batch.owner_scale_y[i]);
+		__m128 scale_x = _mm_mul_ps(_mm_loadu_ps(&batch.owner_scale_x[i]), shrink);
+		__m128 scale_y = _mm_mul_ps(_mm_mul_ps(owner_scale_y, shrink), _mm_set1_ps(1.5f));
+		_mm_storeu_ps(&batch.scale_x[i], scale_x);
+		_mm_storeu_ps(&batch.scale_y[i], scale_y);
+		_mm_storeu_ps(&batch.x[i], _mm_add_ps(owner_x, _mm_mul_ps(cos_angle, _mm_mul_ps(scale_y, half))));
+		_mm_storeu_ps(&batch.y[i], _mm_add_ps(_mm_add_ps(owner_y, _mm_mul_ps(owner_scale_y, half)), _mm_mul_ps(_mm_mul_ps(scale_y, half), sin_angle)));
+	}
+#endif
+	for (; i < n; i++)
+		shadow_scalar(batch, i, light_x, light_y, inv_width, inv_height, light_radius_sq, max_dist, inv_max_dist);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "components.hpp"
+
+#include <cstddef>
+#include <vector>
+
+// Batch kernels of the physics system over packed arrays.
+
+// position += step_seconds * awake * velocity over the first n entries of the packed position field
+// and velocities (the movers group). prev_position is left alone, PhysicsSystem::beginTick sets it.
+void integrate_kernel(vec2* position, const Velocity* velocities, const float* awake, float step_seconds, size_t n);
+
+// atan2(y, x) within 1e-5 radians
+float approx_atan2(float y, float x);
+
+// The shadows being updated, filled by the caller with the inputs and read back for the outputs
+struct ShadowBatch {
+	// in: the owner's position and scale, and the shadow's position from the last tick
+	std::vector<float> owner_x, owner_y, owner_scale_x, owner_scale_y, shadow_x, shadow_y;
+	// out: the shadow's new position, angle and scale, 1 when in range of the light and 0 otherwise
+	std::vector<float> x, y, angle, scale_x, scale_y, active;
+
+	size_t size() const { return owner_x.size(); }
+	void clear();
+	void push_back(float owner_x, float owner_y, float owner_scale_x, float owner_scale_y, float shadow_x, float shadow_y);
+};
+
+// Shadows cast away from the light at (light_x, light_y). The light reaches light_radius in screen
+// units (window_width x window_height) and shadows shrink to nothing at max_dist. Runs 4 shadows at a
+// time with SSE2 and one by one otherwise, both paths compute the same operations in the same order.
+void shadow_kernel(ShadowBatch& batch, float light_x, float light_y,
+	float window_width, float window_height, float light_radius, float max_dist);
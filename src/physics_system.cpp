@@ -1,6 +1,8 @@
 // internal
 #include "physics_system.hpp"
 #include "world_init.hpp"
+#include <algorithm>
+#include <limits>
 
 // Returns the local bounding coordinates scaled by the current size of the entity
 vec2 get_bounding_box(const Position& position)
@@ -26,206 +28,562 @@ bool circleCollides(const Position& position1, const Position& position2)
 	return false;
 }
 
-vec2 worldTransform(vec2 coords, Position& position) {
-	// !!! TODO: add rotation
-	return vec2(coords.x * position.scale.x + position.position.x, coords.y * position.scale.y + position.position.y);
+// Convex hull of the mesh vertices in counter-clockwise order (monotone chain)
+std::vector<vec2> convexHull(const std::vector<ColoredVertex>& vertices)
+{
+	std::vector<vec2> points;
+	for (const ColoredVertex& vertex : vertices)
+		points.push_back({ vertex.position.x, vertex.position.y });
+	std::sort(points.begin(), points.end(), [](vec2 a, vec2 b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+	points.erase(std::unique(points.begin(), points.end()), points.end());
+	if (points.size() < 3)
+		return points;
+
+	auto cross = [](vec2 o, vec2 a, vec2 b) { return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x); };
+	std::vector<vec2> hull(2 * points.size());
+	size_t k = 0;
+	for (size_t i = 0; i < points.size(); i++) {
+		while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
+		hull[k++] = points[i];
+	}
+	for (size_t i = points.size() - 1, lower = k + 1; i > 0; i--) {
+		while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0) k--;
+		hull[k++] = points[i - 1];
+	}
+	hull.resize(k - 1); // the last point is the first one again
+	return hull;
 }
 
-// Reference: 
-// https://github.com/OneLoneCoder/Javidx9/blob/master/PixelGameEngine/SmallerProjects/OneLoneCoder_PGE_PolygonCollisions1.cpp?fbclid=IwAR1e0EyRPtFFGmg1EuiiKU9JxBwOAFN42YA3LIvfm0GHspBbE1df43ZeCz8
-void diagonalCollides(Entity& ent_i, Entity& ent_j)
+// Project the polygon on axis
+void project(const std::vector<vec2>& polygon, vec2 axis, float& min, float& max)
 {
-	Entity* entity_i = &ent_i;
-	Entity* entity_j = &ent_j;
-	bool flag = false;
+	min = max = dot(polygon[0], axis);
+	for (size_t i = 1; i < polygon.size(); i++) {
+		float d = dot(polygon[i], axis);
+		min = std::min(min, d);
+		max = std::max(max, d);
+	}
+}
 
-	for (int obj = 0; obj < 2; obj++) {
-		if (obj == 1) {
-			entity_i = &ent_j;
-			entity_j = &ent_i;
-		}
-		std::vector<ColoredVertex> i_vertices = registry.meshPtrs.get(*entity_i)->vertices;
-		std::vector<ColoredVertex> j_vertices = registry.meshPtrs.get(*entity_j)->vertices;
-		// figure how to get vertices of things also made for textures
-
-		Position& position_i = registry.positions.get(*entity_i);
-		Position& position_j = registry.positions.get(*entity_j);
-
-		for (uint i = 0; i < i_vertices.size(); i++)
-		{
-			vec2 i_line_start = position_i.position;
-			// Will need to add rotation into transformation as well
-			vec2 i_line_end = worldTransform(vec2(i_vertices[i].position.x, i_vertices[i].position.y), position_i);
-			vec2 displacement = { 0, 0 };
-
-			for (uint j = 0; j < j_vertices.size(); j++) {
-				uint next_point = (j + 1) % j_vertices.size();
-				vec2 j_line_start = worldTransform(vec2(j_vertices[j].position.x, j_vertices[j].position.y), position_j);
-				vec2 j_line_end = worldTransform(vec2(j_vertices[next_point].position.x, j_vertices[next_point].position.y), position_j);
-
-				// Line segment intersection
-				float h = (j_line_end.x - j_line_start.x) * (i_line_start.y - i_line_end.y) - (i_line_start.x - i_line_end.x) * (j_line_end.y - j_line_start.y);
-				float t = ((j_line_start.y - j_line_end.y) * (i_line_start.x - j_line_start.x) + (j_line_end.x - j_line_start.x) * (i_line_start.y - j_line_start.y)) / h;
-				float r = ((i_line_start.y - i_line_end.y) * (i_line_start.x - j_line_start.x) + (i_line_end.x - i_line_start.x) * (i_line_start.y - j_line_start.y)) / h;
-
-				if (t >= 0.0f && t < 1.0f && r >= 0.0f && r < 1.0f)
-				{
-					displacement.x += (1.0f - t) * (i_line_end.x - i_line_start.x);
-					displacement.y += (1.0f - t) * (i_line_end.y - i_line_start.y);
-					flag = true;
-				}
-			}
-			if (flag) {
-				// ent_i is obj = 0 meaning it penetrated ent_j, so displacement is negative so we pull back ent_i's position
-				registry.collisions.emplace_with_duplicates(ent_i, ent_j, (obj == 0) ? -displacement : displacement);
-				// ent_j is obj = 0 meaning it penetrated ent_i, so displacement is positive to push away ent_i
-				registry.collisions.emplace_with_duplicates(ent_j, ent_i, (obj == 0) ? displacement : -displacement);
-				return;
-			}
+// Tests the edge normals of 'edges' as separating axes. Returns false when one separates the polygons,
+// otherwise lowers depth/axis to the shortest push of a out of b found.
+bool overlapsOnEdgeNormals(const std::vector<vec2>& edges, const std::vector<vec2>& a, const std::vector<vec2>& b, float& depth, vec2& axis)
+{
+	for (size_t i = 0; i < edges.size(); i++) {
+		vec2 edge = edges[(i + 1) % edges.size()] - edges[i];
+		float length = sqrt(dot(edge, edge));
+		if (length == 0.f) continue;
+		vec2 normal = vec2(-edge.y, edge.x) / length;
+		float min_a, max_a, min_b, max_b;
+		project(a, normal, min_a, max_a);
+		project(b, normal, min_b, max_b);
+		// a leaves b either forwards along the normal or backwards
+		float forwards = max_b - min_a, backwards = max_a - min_b;
+		if (forwards <= 0.f || backwards <= 0.f)
+			return false;
+		if (std::min(forwards, backwards) < depth) {
+			depth = std::min(forwards, backwards);
+			axis = forwards < backwards ? normal : -normal;
 		}
 	}
-	return;
+	return true;
 }
 
-// Function that checks if two entities collides using an axis-aligned bounding-box implementation.
-// If there is a collision between two entities, add a Collision component to the Component container
-// marking both entities involved in the collision and the direction which entity i hit entity j from.
-bool AABBCollides(Entity& entity_i, Entity& entity_j)
+// Separating axis test between two convex polygons. On overlap, mtv is the smallest translation
+// moving a out of b.
+bool separatingAxisCollides(const std::vector<vec2>& a, const std::vector<vec2>& b, vec2& mtv)
 {
-	auto& position_container = registry.positions;
-	Position& position_i = position_container.get(entity_i);
-	Position& position_j = position_container.get(entity_j);
+	if (a.size() < 3 || b.size() < 3)
+		return false;
+	float depth = std::numeric_limits<float>::max();
+	vec2 axis = { 0, 0 };
+	if (!overlapsOnEdgeNormals(a, a, b, depth, axis) || !overlapsOnEdgeNormals(b, a, b, depth, axis))
+		return false;
+	mtv = axis * depth;
+	return true;
+}
 
-	float i_left = position_i.position.x - abs(position_i.scale.x) / 2;
-	float i_right = position_i.position.x + abs(position_i.scale.x) / 2;
-	float i_top = position_i.position.y - abs(position_i.scale.y) / 2;
-	float i_bottom = position_i.position.y + abs(position_i.scale.y) / 2;
-	float j_left = position_j.position.x - abs(position_j.scale.x) / 2;
-	float j_right = position_j.position.x + abs(position_j.scale.x) / 2;
-	float j_top = position_j.position.y - abs(position_j.scale.y) / 2;
-	float j_bottom = position_j.position.y + abs(position_j.scale.y) / 2;
+const std::vector<vec2>& PhysicsSystem::getHull(Entity entity)
+{
+	uint64_t version = registry.positions.version(entity);
+	const Mesh* mesh = registry.meshPtrs.get(entity);
+	if (hull_cache.size() <= entity.index())
+		hull_cache.resize(entity.index() + 1);
+	CachedHull& cached = hull_cache[entity.index()];
+	if (version != 0 && cached.version == version && cached.mesh == mesh)
+		return cached.points;
 
-	if (i_left <= j_right && i_right >= j_left && i_bottom >= j_top && i_top <= j_bottom)
-	{
-		return true;
+	auto local = local_hulls.find(mesh);
+	if (local == local_hulls.end())
+		local = local_hulls.emplace(mesh, convexHull(mesh->vertices)).first;
+
+	// Same transformation as the renderer: scale, then rotate, then translate
+	PositionRef position = registry.positions.get(entity);
+	float c = cosf(position.angle), s = sinf(position.angle);
+	cached.points.resize(local->second.size());
+	for (size_t i = 0; i < local->second.size(); i++) {
+		vec2 p = local->second[i] * position.scale;
+		cached.points[i] = position.position + vec2(c * p.x - s * p.y, s * p.x + c * p.y);
 	}
-	return false;
+	cached.version = version;
+	cached.mesh = mesh;
+	return cached.points;
 }
 
-// Shouldn't care if terrain-terrain and exitDoor-terrain collisions happen
-bool shouldIgnoreCollision(Entity& entity_i, Entity& entity_j) 
+void PhysicsSystem::resolveSweptHits()
 {
-	if (registry.terrain.has(entity_i) && registry.terrain.has(entity_j)) {
-		if (registry.terrain.get(entity_i).moveable || registry.terrain.get(entity_j).moveable) {
-			return false;
+	// Left inside the other body by this much, so the collidedLeft/Right/Top/Bottom checks see the contact
+	const float contact_depth = 0.01f;
+
+	std::stable_sort(swept_hits.begin(), swept_hits.end(), [](const SweptHit& a, const SweptHit& b) {
+		return (unsigned int)a.mover < (unsigned int)b.mover || (a.mover == b.mover && a.time < b.time);
+	});
+	for (size_t k = 0; k < swept_hits.size(); k++) {
+		SweptHit hit = swept_hits[k];
+		if (k > 0 && swept_hits[k - 1].mover == hit.mover)
+			continue;
+
+		// Put the mover where it touched the other body, relative to where that body ended up
+		PositionRef mover_position = registry.positions.patch(hit.mover);
+		PositionRef other_position = registry.positions.get(hit.other);
+		vec2 mover_at_contact = mix(mover_position.prev_position, mover_position.position, hit.time);
+		vec2 other_at_contact = mix(other_position.prev_position, other_position.position, hit.time);
+		mover_position.position = other_position.position + (mover_at_contact - other_at_contact) - hit.normal * contact_depth;
+
+		registry.collisions.emplace_with_duplicates(hit.mover, hit.other, hit.normal * contact_depth);
+		registry.collisions.emplace_with_duplicates(hit.other, hit.mover, -hit.normal * contact_depth);
+	}
+}
+
+// Box around a shape of the given scale and angle at 'center', large enough for the rotation
+AABB get_aabb(vec2 center, vec2 scale, float angle)
+{
+	vec2 half_size = abs(scale) / 2.f;
+	if (angle != 0.f) {
+		float c = abs(cosf(angle)), s = abs(sinf(angle));
+		half_size = vec2(c * half_size.x + s * half_size.y, s * half_size.x + c * half_size.y);
+	}
+	return { center.x - half_size.x, center.y - half_size.y, center.x + half_size.x, center.y + half_size.y };
+}
+
+// Box around the entity at 'center'
+AABB get_aabb(const Position& position, vec2 center)
+{
+	return get_aabb(center, position.scale, position.angle);
+}
+
+AABB get_aabb(const Position& position)
+{
+	return get_aabb(position, position.position);
+}
+
+// Smallest box covering both
+AABB merge_aabb(const AABB& a, const AABB& b)
+{
+	return { std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom) };
+}
+
+// Time of impact of the box of a moving by 'motion' (relative to b) against the box of b, both taken at
+// prev_position. False when they don't meet within the tick or already overlap at its start.
+bool sweptAABBCollides(const AABB& a, const AABB& b, vec2 motion, float& time, vec2& normal)
+{
+	float entry[2], exit[2];
+	float a_min[2] = { a.left, a.top }, a_max[2] = { a.right, a.bottom };
+	float b_min[2] = { b.left, b.top }, b_max[2] = { b.right, b.bottom };
+	for (int axis = 0; axis < 2; axis++) {
+		if (motion[axis] > 0.f) {
+			entry[axis] = (b_min[axis] - a_max[axis]) / motion[axis];
+			exit[axis] = (b_max[axis] - a_min[axis]) / motion[axis];
+		}
+		else if (motion[axis] < 0.f) {
+			entry[axis] = (b_max[axis] - a_min[axis]) / motion[axis];
+			exit[axis] = (b_min[axis] - a_max[axis]) / motion[axis];
+		}
+		else {
+			if (a_max[axis] < b_min[axis] || a_min[axis] > b_max[axis])
+				return false;
+			entry[axis] = -std::numeric_limits<float>::infinity();
+			exit[axis] = std::numeric_limits<float>::infinity();
 		}
-		return true;
 	}
-	if ((registry.terrain.has(entity_i) && registry.exitDoors.has(entity_j)) ||
-		(registry.exitDoors.has(entity_i) && registry.terrain.has(entity_j))) {
-		return true;
+	int axis = entry[0] > entry[1] ? 0 : 1;
+	time = entry[axis];
+	if (time < 0.f || time > 1.f || time > std::min(exit[0], exit[1]))
+		return false;
+	normal = vec2(0.f, 0.f);
+	normal[axis] = motion[axis] > 0.f ? -1.f : 1.f;
+	return true;
+}
+
+void PhysicsSystem::narrowPhase(const std::pair<unsigned int, unsigned int>& pair, ContactBuffer& out) const
+{
+	auto& collidables_container = registry.collidables;
+	Entity entity_i = collidables_container.entities[pair.first];
+	Entity entity_j = collidables_container.entities[pair.second];
+	bool continuous_i = collidables_container.components[pair.first].continuous;
+	bool continuous_j = collidables_container.components[pair.second].continuous;
+	if (continuous_i || continuous_j) {
+		// Bodies already touching at the start of the tick go through the regular test
+		Entity mover = continuous_i ? entity_i : entity_j, other = continuous_i ? entity_j : entity_i;
+		PositionRef mover_position = registry.positions.get(mover);
+		PositionRef other_position = registry.positions.get(other);
+		vec2 motion = (mover_position.position - mover_position.prev_position) - (other_position.position - other_position.prev_position);
+		float time;
+		vec2 normal;
+		if (sweptAABBCollides(get_aabb(mover_position, mover_position.prev_position), get_aabb(other_position, other_position.prev_position), motion, time, normal)) {
+			out.swept_hits.push_back({ mover, other, time, normal });
+			return;
+		}
 	}
-	return false;
+
+	vec2 mtv;
+	if (separatingAxisCollides(hull_cache[entity_i.index()].points, hull_cache[entity_j.index()].points, mtv))
+		out.contacts.push_back({ entity_i, entity_j, mtv });
+}
+
+bool isStaticTerrain(Entity entity)
+{
+	Terrain* terrain = registry.terrain.try_get(entity);
+	return terrain != nullptr && !terrain->moveable;
+}
+
+
+// Moves every entity in the movers group by its velocity. The group keeps positions and velocities
+// in lockstep at the front of their containers, so this is one pass over the packed position fields.
+void integrate(float step_seconds, const std::vector<float>& awake)
+{
+	typedef soa_layout<Position> P;
+	auto& positions = registry.positions;
+	auto& velocities = registry.velocities;
+	const size_t n = registry.movers.size();
+
+	integrate_kernel(positions.field<P::POSITION>().data, velocities.components.data(), awake.data(), step_seconds, n);
+
+	// Only what actually moved counts as changed
+	for (size_t i = 0; i < n; i++)
+		if (awake[i] != 0.f && velocities.components[i].velocity != vec2(0.f))
+			positions.touch(positions.entities[i]);
 }
 
-void updateShadows() {
+// Shadows are gathered into a packed batch, updated by the shadow kernel and scattered back
+void PhysicsSystem::updateShadows() {
 	Entity player_entity = registry.players.entities[0];
 	
-	Position& light_source_pos = (registry.lifeOrbs.entities.size() > 0)
-		? registry.positions.get(registry.lifeOrbs.entities[0])
-		: registry.positions.get(player_entity); //
+	// A copy, removing orphaned shadows below reorders the position arrays
+	vec2 light_source_pos = (registry.lifeOrbs.entities.size() > 0)
+		? registry.positions.get(registry.lifeOrbs.entities[0]).position
+		: registry.positions.get(player_entity).position; //
+
+	typedef soa_layout<Position> P;
+	auto& positions = registry.positions;
+	shadow_batch.clear();
+	shadow_entities.clear();
+	orphan_shadows.clear();
+	{
+		auto position = positions.field<P::POSITION>();
+		auto scale = positions.field<P::SCALE>();
+		for (uint i = 0; i < registry.shadows.size(); i++) {
+			Entity entity = registry.shadows.entities[i];
+			Entity owner = registry.shadows.components[i].owner;
+			if (!positions.has(entity))
+				continue;
+			if (!positions.has(owner)) {
+				orphan_shadows.push_back(entity);
+				continue;
+			}
+			unsigned int o = positions.index_of(owner), s = positions.index_of(entity);
+			shadow_batch.push_back(position[o].x, position[o].y, scale[o].x, scale[o].y, position[s].x, position[s].y);
+			shadow_entities.push_back(entity);
+		}
+	}
+	for (Entity entity : orphan_shadows)
+		registry.remove_all_components_of(entity);
 
-	for (uint i = 0; i < registry.shadows.entities.size(); i++) {
-		Entity entity = registry.shadows.entities[i];
-		Shadow& shadow = registry.shadows.get(entity);
+	float max_dist = light_radius*std::max(window_width_px, window_height_px);
+	shadow_kernel(shadow_batch, light_source_pos.x, light_source_pos.y,
+		(float)window_width_px, (float)window_height_px, light_radius, max_dist);
 
-		Entity owner_entity = shadow.owner;
+	auto position = positions.field<P::POSITION>();
+	auto angle = positions.field<P::ANGLE>();
+	auto scale = positions.field<P::SCALE>();
+	for (size_t i = 0; i < shadow_entities.size(); i++) {
+		Entity entity = shadow_entities[i];
+		registry.shadows.get(entity).active = shadow_batch.active[i] != 0.f;
+		unsigned int s = positions.index_of(entity);
+		position[s] = { shadow_batch.x[i], shadow_batch.y[i] };
+		angle[s] = shadow_batch.angle[i];
+		scale[s] = { shadow_batch.scale_x[i], shadow_batch.scale_y[i] };
+		positions.touch(entity);
+	}
+}
 
-		Position& shadow_pos = registry.positions.get(entity);
-		if (!registry.positions.has(owner_entity)) {
-			registry.remove_all_components_of(entity);
+void PhysicsSystem::bakeStaticTerrain()
+{
+	static_entities.clear();
+	boxes.clear();
+	static_filter = { 0, 0 };
+	for (Entity entity : registry.terrain.entities) {
+		if (!isStaticTerrain(entity) || !registry.collidables.has(entity) || !registry.positions.has(entity))
 			continue;
-		}
-		Position& owner_pos = registry.positions.get(owner_entity);
-		shadow.active = true;
+		static_entities.push_back(entity);
+		boxes.push_back(get_aabb(registry.positions.get(entity)));
+		static_filter.category |= registry.collidables.get(entity).category;
+		static_filter.mask |= registry.collidables.get(entity).mask;
+	}
+	static_grid.bake(boxes);
+	baked_terrain_revision = registry.terrain.revision();
+}
 
-		if (distance((shadow_pos.position / vec2(window_width_px, window_height_px)), 
-			(light_source_pos.position / vec2(window_width_px, window_height_px))) > light_radius) {
-			shadow.active = false;
-		}
+void PhysicsSystem::bakeSleepingBodies()
+{
+	sleeping_entities.clear();
+	boxes.clear();
+	for (Entity entity : registry.sleeping.entities) {
+		if (!registry.collidables.has(entity) || !registry.positions.has(entity))
+			continue;
+		sleeping_entities.push_back(entity);
+		boxes.push_back(get_aabb(registry.positions.get(entity)));
+	}
+	sleeping_grid.bake(boxes);
+	baked_sleeping_revision = registry.sleeping.revision();
+}
+
+PhysicsSystem::RestState& PhysicsSystem::restState(Entity entity)
+{
+	if (rest_states.size() <= entity.index())
+		rest_states.resize(entity.index() + 1);
+	RestState& state = rest_states[entity.index()];
+	if (!(state.entity == entity))
+		state = RestState{ entity };
+	return state;
+}
 
-		shadow_pos.position = owner_pos.position;
+void PhysicsSystem::wakeIsland(Entity entity)
+{
+	std::vector<Entity> island = { entity };
+	while (!island.empty()) {
+		Entity body = island.back();
+		island.pop_back();
+		if (!registry.sleeping.has(body))
+			continue;
+		registry.sleeping.remove(body);
+		restState(body).still_ticks = 0;
 
-		// M_PI / 2 is to make the shadow upright
-		shadow_pos.angle = atan2(owner_pos.position.y - light_source_pos.position.y, owner_pos.position.x - light_source_pos.position.x) + M_PI/2;
+		// The grid still holds the bodies asleep at the last bake
+		static_hits.clear();
+		sleeping_grid.query(get_aabb(registry.positions.get(body)), static_hits);
+		for (unsigned int hit : static_hits)
+			island.push_back(sleeping_entities[hit]);
+	}
+}
+
+void PhysicsSystem::updateSleeping()
+{
+	// Bodies slower than this for sleep_ticks in a row fall asleep, unless within wake_radius of the player
+	const float sleep_speed = 1.f;
+	const int sleep_ticks = 30;
+	const float wake_radius = (float)std::max(window_width_px, window_height_px);
 
-		float max_dist = light_radius*std::max(window_width_px, window_height_px);
+	vec2 player_position = registry.positions.get(registry.players.entities[0]).position;
+	const size_t n = registry.movers.size();
+	awake.assign(n, 1.f);
+	for (size_t i = 0; i < n; i++) {
+		Entity entity = registry.positions.entities[i];
+		vec2 velocity = registry.velocities.components[i].velocity;
+		PositionRef position = registry.positions.components[i];
+		RestState& state = restState(entity);
+		bool still = dot(velocity, velocity) <= sleep_speed * sleep_speed &&
+			distance(position.position, player_position) > wake_radius;
 
-		float dist = abs(distance(owner_pos.position, light_source_pos.position));
-		shadow_pos.scale = owner_pos.scale * (max_dist - dist) / max_dist;
-		shadow_pos.scale.y *= 1.5;
+		if (registry.sleeping.has(entity)) {
+			// Woken by a new velocity, by being moved or by the player coming close
+			if (still && registry.positions.version(entity) == state.slept_version)
+				awake[i] = 0.f;
+			else
+				wakeIsland(entity);
+			continue;
+		}
+		state.still_ticks = still ? state.still_ticks + 1 : 0;
+		if (state.still_ticks >= sleep_ticks) {
+			registry.sleeping.emplace(entity);
+			state.slept_version = registry.positions.version(entity);
+			awake[i] = 0.f;
+		}
+	}
+}
 
-		shadow_pos.position.x += cos(shadow_pos.angle - M_PI / 2) * (shadow_pos.scale.y / 2);
-		shadow_pos.position.y += owner_pos.scale.y / 2 + shadow_pos.scale.y / 2 * sin(shadow_pos.angle - M_PI/2);
+void PhysicsSystem::beginTick()
+{
+	auto& positions = registry.positions;
+	for (uint i = 0; i < positions.size(); i++) {
+		Entity entity = positions.entities[i];
+		positions.components[i].prev_position = positions.components[i].position;
+		if (tick_entities.size() <= entity.index())
+			tick_entities.resize(entity.index() + 1);
+		tick_entities[entity.index()] = entity;
 	}
+	tick_revision = positions.revision();
+}
+
+void PhysicsSystem::endTick()
+{
+	registry.positions.each_changed(tick_revision, [&](Entity entity, PositionRef position) {
+		bool existed = entity.index() < tick_entities.size() && tick_entities[entity.index()] == entity;
+		if (!existed)
+			position.prev_position = position.position;
+	});
 }
 
 void PhysicsSystem::step(float elapsed_ms)
 {
 	if (registry.deathTimers.entities.size() > 0) return;
-	auto& velocity_container = registry.velocities;
-	for (uint i = 0; i < velocity_container.size(); i++)
-	{
-		Entity entity = velocity_container.entities[i];
-		if (!velocity_container.has(entity) || !registry.positions.has(entity)) continue;
-		Velocity& velocity = velocity_container.get(entity);
-		Position& position = registry.positions.get(entity);
-		float step_seconds = elapsed_ms / 1000.f;
-		position.prev_position = position.position;
-		position.position[0] += step_seconds * velocity.velocity[0];
-		position.position[1] += step_seconds * velocity.velocity[1];
-	}
+	updateSleeping();
+	integrate(elapsed_ms / 1000.f, awake);
 
 	// Update shadows
 	updateShadows();
 
 	// Check for collisions between things that are collidable
+	// Static terrain never collides with itself and is only baked when a level adds or removes terrain
+	if (registry.terrain.revision() != baked_terrain_revision)
+		bakeStaticTerrain();
+	// Sleeping bodies are handled the same way, awake bodies query them but they don't query anything
+	if (registry.sleeping.revision() != baked_sleeping_revision)
+		bakeSleepingBodies();
+
+	typedef soa_layout<Position> P;
 	auto& collidables_container = registry.collidables;
-	for (uint i = 0; i < collidables_container.size(); i++) {
-		Entity& entity_i = collidables_container.entities[i];
-		for (uint j = i+1; j < collidables_container.size(); j++) {
-			Entity& entity_j = collidables_container.entities[j];
-			// Ignore terrain-terrain and terrain-exitDoor collision
-			if (shouldIgnoreCollision(entity_i, entity_j)) continue;
-			// Broad phase of collision check
-			if (AABBCollides(entity_i, entity_j)) {
-				// Narrow phase of collision check
-				diagonalCollides(entity_i, entity_j);
-			}
+	auto position = registry.positions.field<P::POSITION>();
+	auto prev_position = registry.positions.field<P::PREV_POSITION>();
+	auto angle = registry.positions.field<P::ANGLE>();
+	auto scale = registry.positions.field<P::SCALE>();
+	boxes.clear();
+	dynamic_bodies.clear();
+	for (uint i = 0; i < registry.colliders.size(); i++) {
+		Entity entity = collidables_container.entities[i];
+		if (isStaticTerrain(entity) || registry.sleeping.has(entity)) continue;
+		dynamic_bodies.push_back(i);
+		unsigned int k = registry.positions.index_of(entity);
+		AABB box = get_aabb(position[k], scale[k], angle[k]);
+		// Continuous colliders are entered with their whole path of the tick
+		if (collidables_container.components[i].continuous)
+			box = merge_aabb(get_aabb(prev_position[k], scale[k], angle[k]), box);
+		boxes.push_back(box);
+	}
 
+	// Broad phase of collision check, the pairs with overlapping AABBs as indices into the colliders:
+	// dynamic bodies among themselves and against the static grid. Pairs whose categories and masks
+	// don't match are dropped here, handle_collisions has nothing to do for them.
+	candidates.clear();
+	broadphase.build(boxes);
+	for (const auto& pair : broadphase.pairs()) {
+		unsigned int i = dynamic_bodies[pair.first], j = dynamic_bodies[pair.second];
+		if (collidables_container.components[i].collidesWith(collidables_container.components[j]))
+			candidates.emplace_back(i, j);
+	}
+	for (uint k = 0; k < dynamic_bodies.size(); k++) {
+		unsigned int i = dynamic_bodies[k];
+		const Collidable& collidable = collidables_container.components[i];
+		// Bodies that collide with no static terrain skip the grid
+		if (!collidable.collidesWith(static_filter)) continue;
+		static_hits.clear();
+		static_grid.query(boxes[k], static_hits);
+		for (unsigned int hit : static_hits) {
+			unsigned int j = collidables_container.index_of(static_entities[hit]);
+			if (collidable.collidesWith(collidables_container.components[j]))
+				candidates.emplace_back(std::min(i, j), std::max(i, j));
+		}
+	}
+	for (uint k = 0; k < dynamic_bodies.size(); k++) {
+		unsigned int i = dynamic_bodies[k];
+		static_hits.clear();
+		sleeping_grid.query(boxes[k], static_hits);
+		for (unsigned int hit : static_hits) {
+			unsigned int j = collidables_container.index_of(sleeping_entities[hit]);
+			if (collidables_container.components[i].collidesWith(collidables_container.components[j]))
+				candidates.emplace_back(std::min(i, j), std::max(i, j));
 		}
 	}
+	// Same order as testing all pairs in a nested loop
+	std::sort(candidates.begin(), candidates.end());
 
-	// update position of entities that follow player or enemies to remove jitter
-	for (int i = 0; i < registry.followers.size(); i++) {
-		Follower& follower = registry.followers.components[i];
-		Entity entity = registry.followers.entities[i];
-		Position& position = registry.positions.get(entity);
-		Position& owner_position = registry.positions.get(follower.owner);
-		position.position = owner_position.position;
-		position.position.y += follower.y_offset;
-		position.position.x += follower.x_offset;
+	// Narrow phase of collision check. The hulls are brought up to date first, the workers only read them.
+	for (const auto& pair : candidates) {
+		getHull(collidables_container.entities[pair.first]);
+		getHull(collidables_container.entities[pair.second]);
 	}
+	const unsigned int chunk_size = 64;
+	unsigned int chunks = (unsigned int)((candidates.size() + chunk_size - 1) / chunk_size);
+	if (contact_buffers.size() < chunks)
+		contact_buffers.resize(chunks);
+	workers.run(chunks, [&](unsigned int chunk) {
+		ContactBuffer& buffer = contact_buffers[chunk];
+		buffer.contacts.clear();
+		buffer.swept_hits.clear();
+		size_t end = std::min(candidates.size(), (size_t)(chunk + 1) * chunk_size);
+		for (size_t k = (size_t)chunk * chunk_size; k < end; k++)
+			narrowPhase(candidates[k], buffer);
+	});
+
+	swept_hits.clear();
+	for (unsigned int chunk = 0; chunk < chunks; chunk++) {
+		for (Contact& contact : contact_buffers[chunk].contacts) {
+			// The displacement of each entity pushes it out of the other
+			registry.collisions.emplace_with_duplicates(contact.entity_i, contact.entity_j, contact.mtv);
+			registry.collisions.emplace_with_duplicates(contact.entity_j, contact.entity_i, -contact.mtv);
+		}
+		swept_hits.insert(swept_hits.end(), contact_buffers[chunk].swept_hits.begin(), contact_buffers[chunk].swept_hits.end());
+	}
+	resolveSweptHits();
+
+	// Sleeping bodies something ran into wake up, with whatever rests against them
+	for (Entity entity : registry.collisions.entities)
+		if (registry.sleeping.has(entity))
+			wakeIsland(entity);
+}
+
+void PhysicsSystem::propagateTransforms()
+{
+	auto& parents = registry.parents;
 
-	// 2nd phase of position correction strictly after first phase
-	for (int i = 0; i < registry.secondaryFollowers.size(); i++) {
-		SecondaryFollower& follower = registry.secondaryFollowers.components[i];
-		Entity entity = registry.secondaryFollowers.entities[i];
-		Position& position = registry.positions.get(entity);
-		Position& owner_position = registry.positions.get(follower.owner);
-		position.position = owner_position.position;
-		position.position.y += follower.y_offset;
-		position.position.x += follower.x_offset;
+	// Depths are refreshed from the parent's. A parent behind its child (attached later, or moved by a
+	// removal) makes the pass re-sort, each round settles at least one more level.
+	bool sorted = false;
+	for (size_t round = 0; !sorted; round++) {
+		// Without a cycle the depth of every link settles within as many rounds as there are links. Past
+		// that the deepest link is on a cycle or hangs below one, and as many steps up from it are on the
+		// cycle. Cut the cycle there, the entity keeps its last position.
+		if (round > parents.size()) {
+			auto deepest = std::max_element(parents.components.begin(), parents.components.end(),
+				[](const Parent& a, const Parent& b) { return a.depth < b.depth; });
+			Entity entity = parents.entities[deepest - parents.components.begin()];
+			for (size_t step = 0; step < parents.size(); step++)
+				entity = parents.get(entity).entity;
+			fprintf(stderr, "Cycle in the transform hierarchy, detaching entity %u from its parent\n", (unsigned int)entity);
+			parents.remove(entity);
+			round = 0;
+		}
+		sorted = true;
+		for (unsigned int i = 0; i < parents.size(); i++) {
+			Parent& link = parents.components[i];
+			Parent* up = parents.try_get(link.entity);
+			link.depth = up != nullptr ? up->depth + 1 : 1;
+			if (up != nullptr && parents.index_of(link.entity) > i)
+				sorted = false;
+		}
+		if (!sorted)
+			parents.sort_by_key([](const Parent& link) { return link.depth; });
 	}
 
+	// Parents first, so every parent's position is final by the time its children read it
+	for (unsigned int i = 0; i < parents.size(); i++) {
+		const Parent& link = parents.components[i];
+		Entity entity = parents.entities[i];
+		auto parent_position = registry.positions.try_get(link.entity);
+		if (parent_position == nullptr || !registry.positions.has(entity))
+			continue;
+		vec2 world = parent_position->position + link.offset;
+		if (registry.positions.get(entity).position != world)
+			registry.positions.patch(entity).position = world;
+	}
 }
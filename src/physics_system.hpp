@@ -4,6 +4,11 @@
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 #include "tiny_ecs_registry.hpp"
+#include "broadphase.hpp"
+#include "worker_pool.hpp"
+#include "physics_kernels.hpp"
+
+#include <unordered_map>
 
 // A simple physics system that moves rigid bodies and checks for collision
 class PhysicsSystem
@@ -11,7 +16,102 @@ class PhysicsSystem
 public:
 	void step(float elapsed_ms);
 
-	PhysicsSystem()
+	// Called around every simulation tick. The positions at the start of the tick become prev_position,
+	// and entities created during the tick start with prev_position at their position.
+	void beginTick();
+	void endTick();
+
+	// Moves every entity with a Parent to its parent's position plus offset, in one pass over the
+	// hierarchy. Runs after the collisions of the tick are resolved.
+	void propagateTransforms();
+
+	// threads is the size of the narrowphase worker pool, 0 uses every hardware thread
+	explicit PhysicsSystem(unsigned int threads = 0) : workers(threads)
 	{
 	}
+
+private:
+	// Terrain that can't move, baked into static_grid whenever the terrain container changed.
+	// Body i of the grid is static_entities[i].
+	StaticGrid static_grid;
+	std::vector<Entity> static_entities;
+	uint64_t baked_terrain_revision = ~0ull;
+	// Union of the categories and masks of the static terrain
+	Collidable static_filter;
+	void bakeStaticTerrain();
+
+	// Sleeping colliders, baked into sleeping_grid whenever a body fell asleep or woke up
+	StaticGrid sleeping_grid;
+	std::vector<Entity> sleeping_entities;
+	uint64_t baked_sleeping_revision = ~0ull;
+	void bakeSleepingBodies();
+
+	// Ticks each mover has been at rest for, and its position version when it fell asleep
+	struct RestState {
+		Entity entity;
+		int still_ticks = 0;
+		uint64_t slept_version = 0;
+	};
+	std::vector<RestState> rest_states; // indexed by entity index
+	RestState& restState(Entity entity);
+	// 1 for the movers that are integrated this tick, 0 for the sleeping ones (in movers order)
+	std::vector<float> awake;
+	void updateSleeping();
+	// Wake a body and the sleeping bodies touching it, and the ones touching those
+	void wakeIsland(Entity entity);
+
+	// Shadows updated this tick, entry i of the batch is shadow_entities[i]
+	ShadowBatch shadow_batch;
+	std::vector<Entity> shadow_entities;
+	std::vector<Entity> orphan_shadows;
+	void updateShadows();
+
+	// Broadphase over the other colliders, box i belongs to registry.collidables.entities[dynamic_bodies[i]]
+	SpatialHash broadphase;
+	std::vector<AABB> boxes;
+	std::vector<unsigned int> dynamic_bodies;
+	std::vector<unsigned int> static_hits;
+	std::vector<std::pair<unsigned int, unsigned int>> candidates;
+
+	// The entity holding each index at the start of the tick, and the positions revision then
+	std::vector<Entity> tick_entities;
+	uint64_t tick_revision = 0;
+
+	// World-space convex hull of a collider, rebuilt when its position version changes
+	struct CachedHull {
+		uint64_t version = 0;
+		const Mesh* mesh = nullptr;
+		std::vector<vec2> points;
+	};
+	std::vector<CachedHull> hull_cache; // indexed by entity index
+	std::unordered_map<const Mesh*, std::vector<vec2>> local_hulls;
+	const std::vector<vec2>& getHull(Entity entity);
+
+	// First contact of a continuous collider with another body during the tick, only the earliest
+	// one of each mover is kept
+	struct SweptHit {
+		Entity mover;
+		Entity other;
+		float time;
+		vec2 normal; // out of other, towards mover
+	};
+	std::vector<SweptHit> swept_hits;
+	void resolveSweptHits();
+
+	// Narrow phase of the candidate pairs, run on the worker pool in chunks of consecutive pairs. Each
+	// chunk fills its own buffer and the buffers are merged in chunk order, so the collisions come out
+	// in the same order whatever the number of threads.
+	struct Contact {
+		Entity entity_i;
+		Entity entity_j;
+		vec2 mtv; // moves entity_i out of entity_j
+	};
+	struct ContactBuffer {
+		std::vector<Contact> contacts;
+		std::vector<SweptHit> swept_hits;
+	};
+	WorkerPool workers;
+	std::vector<ContactBuffer> contact_buffers;
+	// Reads the hull cache only, so the hulls of both entities must be up to date
+	void narrowPhase(const std::pair<unsigned int, unsigned int>& pair, ContactBuffer& out) const;
 };
\ No newline at end of file
@@ -5,17 +5,47 @@
 
 #include "tiny_ecs_registry.hpp"
 
+// Sort key of the main pass: layer, then effect, texture and geometry so consecutive draws share state
+static uint64_t drawKey(const RenderRequest& request)
+{
+	return ((uint64_t)request.layer << 48) | ((uint64_t)request.used_effect << 32) |
+		((uint64_t)request.used_texture << 16) | (uint64_t)request.used_geometry;
+}
+
+vec2 RenderSystem::interpolatedPosition(const Position& position) const
+{
+	return mix(position.prev_position, position.position, interpolation);
+}
+
+const mat3& RenderSystem::getTransform(Entity entity)
+{
+	uint64_t version = registry.positions.version(entity);
+	if (transform_cache.size() <= entity.index())
+		transform_cache.resize(entity.index() + 1);
+	CachedTransform& cached = transform_cache[entity.index()];
+	PositionRef position = registry.positions.get(entity);
+	vec2 drawn_position = interpolatedPosition(position);
+	// Static terrain and floors keep their version, everything else is rebuilt when it moves
+	if (version == 0 || cached.version != version || cached.position != drawn_position) {
+		// Transformation code, see Rendering and Transformation in the template
+		// specification for more info Incrementally updates transformation matrix,
+		// thus ORDER IS IMPORTANT
+		Transform transform;
+		transform.translate(drawn_position);
+		transform.rotate(position.angle);
+		transform.scale(position.scale);
+		cached.mat = transform.mat;
+		cached.version = version;
+		cached.position = drawn_position;
+	}
+	return cached.mat;
+}
+
 void RenderSystem::drawTexturedMesh(Entity entity,
 	const mat3& projection)
 {
-	Position& position = registry.positions.get(entity);
-	// Transformation code, see Rendering and Transformation in the template
-	// specification for more info Incrementally updates transformation matrix,
-	// thus ORDER IS IMPORTANT
-	Transform transform;
-	transform.translate(position.position);
-	transform.rotate(position.angle);
-	transform.scale(position.scale);
+	PositionRef position = registry.positions.get(entity);
+	const mat3& transform = getTransform(entity);
 
 	assert(registry.renderRequests.has(entity));
 	const RenderRequest& render_request = registry.renderRequests.get(entity);
@@ -219,7 +249,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 	glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
 	// Setting uniform values to the currently bound program
 	GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
-	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float*)&transform.mat);
+	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float*)&transform);
 	GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
 	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float*)&projection);
 	gl_has_errors();
@@ -296,11 +326,7 @@ void RenderSystem::drawToScreen()
 }
 
 void RenderSystem::drawArsenal(Entity entity, const mat3& projection){
-	Position& position = registry.positions.get(entity);
-	Transform transform;
-	transform.translate(position.position);
-	transform.rotate(position.angle);
-	transform.scale(position.scale);
+	const mat3& transform = getTransform(entity);
 
 	assert(registry.renderRequests.has(entity));
 	const RenderRequest& render_request = registry.renderRequests.get(entity);
@@ -376,7 +402,7 @@ void RenderSystem::drawArsenal(Entity entity, const mat3& projection){
 	glGetIntegerv(GL_CURRENT_PROGRAM, &currProgram);
 	// Setting uniform values to the currently bound program
 	GLuint transform_loc = glGetUniformLocation(currProgram, "transform");
-	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float*)&transform.mat);
+	glUniformMatrix3fv(transform_loc, 1, GL_FALSE, (float*)&transform);
 	GLuint projection_loc = glGetUniformLocation(currProgram, "projection");
 	glUniformMatrix3fv(projection_loc, 1, GL_FALSE, (float*)&projection);
 	gl_has_errors();
@@ -393,8 +419,10 @@ void RenderSystem::drawImGui()
 
 // Render our game world
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
-void RenderSystem::draw()
+void RenderSystem::draw(float alpha)
 {
+	interpolation = alpha;
+
 	// Getting size of window
 	int w, h;
 	glfwGetFramebufferSize(window, &w, &h); // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
@@ -419,15 +447,15 @@ void RenderSystem::draw()
 	// get to players position
 	assert(registry.players.size() >= 1);
 	Entity entity = registry.players.entities[0];
-	Position& player_pos = registry.positions.get(entity);
+	PositionRef player_pos = registry.positions.get(entity);
 
 	// center the camera on the player (or life orb if specified)
 	Camera camera;
 	if (registry.lifeOrbs.size() > 0 && registry.lifeOrbs.components[0].centered_on_screen) {
-		camera.centerAt(registry.positions.get(registry.lifeOrbs.entities[0]).position);
+		camera.centerAt(interpolatedPosition(registry.positions.get(registry.lifeOrbs.entities[0])));
 	}
 	else {
-		camera.centerAt(player_pos.position);
+		camera.centerAt(interpolatedPosition(player_pos));
 	}
 
 	// Handle drawing floors first
@@ -441,17 +469,17 @@ void RenderSystem::draw()
 	}
 
 	// Draw all textured meshes that have a position and size component
-	for (Entity entity : registry.renderRequests.entities)
-	{
-		if (!registry.positions.has(entity) || registry.texts.has(entity) || 
-			registry.shadows.has(entity) || registry.floors.has(entity) ||
-			registry.projectileSelectDisplays.has(entity) || registry.healthBars.has(entity) ||
-			registry.manaBars.has(entity) || registry.powerUpIndicators.has(entity))
-			continue;
-		// Note, its not very efficient to access elements indirectly via the entity
-		// albeit iterating through all Sprites in sequence. A good point to optimize
-		drawTexturedMesh(entity, camera.projectionMat);
+	// (driven by renderRequests to keep their draw order, sorted to minimize state changes)
+	// Only re-sorted after a request was added, removed or patched
+	if (registry.renderRequests.revision() != sorted_requests_revision) {
+		registry.renderRequests.sort_by_key(drawKey);
+		sorted_requests_revision = registry.renderRequests.revision();
 	}
+	registry.view<RenderRequest, Position>(exclude<Text, Shadow, Floor, ProjectileSelectDisplay, HealthBar, ManaBar, PowerUpIndicator>)
+		.use<RenderRequest>()
+		.each([&](Entity entity, RenderRequest&, PositionRef) {
+			drawTexturedMesh(entity, camera.projectionMat);
+		});
 	
 	// Truely render to the screen
 	drawToScreen();
@@ -502,7 +530,7 @@ void RenderSystem::draw()
 void RenderSystem::drawText(Entity entity) {
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	Position& position = registry.positions.get(entity);
+	PositionRef position = registry.positions.get(entity);
 
 	assert(registry.renderRequests.has(entity));
 	const RenderRequest& render_request = registry.renderRequests.get(entity);
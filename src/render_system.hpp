@@ -144,8 +144,8 @@ public:
 	// Destroy resources associated to one or all entities created by the system
 	~RenderSystem();
 
-	// Draw all entities
-	void draw();
+	// Draw all entities, alpha is how far rendering is between the last two simulation ticks
+	void draw(float alpha = 1.f);
 
 	void animation_step(float elapsed_ms);
 
@@ -157,6 +157,23 @@ private:
 	void drawImGui();
 	void drawArsenal(Entity entity, const mat3& projection);
 
+	// World transforms by entity index, rebuilt only when the Position changed (see track_changes)
+	// or the interpolated position moved
+	struct CachedTransform {
+		uint64_t version = 0;
+		vec2 position;
+		mat3 mat;
+	};
+	std::vector<CachedTransform> transform_cache;
+	const mat3& getTransform(Entity entity);
+
+	// Revision of renderRequests when they were last sorted by draw key
+	uint64_t sorted_requests_revision = 0;
+
+	// Position drawn for the current frame, between prev_position and position
+	float interpolation = 1.f;
+	vec2 interpolatedPosition(const Position& position) const;
+
 	// Helper functions for initializeSpriteSheets()
 	void initializePowerUpBlockSpriteSheet();
 	void initializePlayerSpriteSheet();
@@ -1,5 +1,47 @@
 // internal
 #include "tiny_ecs.hpp"
 
-// All we need to store besides the containers is the id of every entity and callbacks to be able to remove entities across containers
-unsigned int Entity::id_count = 1;
\ No newline at end of file
+#include <mutex>
+
+// All we need to store besides the containers is the generation of every entity index and the indices free for re-use
+namespace {
+	std::mutex entity_mutex;
+	std::vector<unsigned int> generations = { 0 }; // index 0 is reserved for the null handle
+	std::vector<unsigned int> free_indices;
+}
+
+Entity Entity::create()
+{
+	std::lock_guard<std::mutex> lock(entity_mutex);
+	unsigned int index;
+	if (!free_indices.empty()) {
+		index = free_indices.back();
+		free_indices.pop_back();
+	}
+	else {
+		index = (unsigned int)generations.size();
+		assert(index <= INDEX_MASK && "Ran out of entity indices");
+		generations.push_back(0);
+	}
+	Entity e;
+	e.id = (generations[index] << INDEX_BITS) | index;
+	return e;
+}
+
+void Entity::release(Entity e)
+{
+	std::lock_guard<std::mutex> lock(entity_mutex);
+	unsigned int index = e.index();
+	if (index == 0 || index >= generations.size() || generations[index] != e.generation())
+		return;
+	// The generation wraps around inside the bits left over by the index
+	generations[index] = (generations[index] + 1) & (~0u >> INDEX_BITS);
+	free_indices.push_back(index);
+}
+
+bool Entity::alive(Entity e)
+{
+	std::lock_guard<std::mutex> lock(entity_mutex);
+	unsigned int index = e.index();
+	return index != 0 && index < generations.size() && generations[index] == e.generation();
+}
\ No newline at end of file
@@ -2,46 +2,269 @@
 
 #include <algorithm>
 #include <vector>
-#include <unordered_map>
 #include <set>
 #include <functional>
+#include <memory>
 #include <typeindex>
+#include <tuple>
+#include <utility>
 #include <assert.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <cstdio>
 
 // Unique identifyer for all entities
+// The 32-bit handle packs an index (low INDEX_BITS) with a generation (high bits). Indices of released
+// entities are recycled through a free list with their generation bumped, so id-indexed storage stays
+// compact and a stale handle to a released entity no longer matches anything in the ECS.
 class Entity
 {
 	unsigned int id;
-	static unsigned int id_count; // starts from 1, entit 0 is the default initialization
 public:
-	Entity()
+	static const unsigned int INDEX_BITS = 20;
+	static const unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1;
+
+	// Default constructed entities are the null handle, use Entity::create() to allocate a new one
+	Entity() : id(0) {}
+
+	// Allocate a fresh handle, re-using the index of a released entity if possible (thread-safe)
+	static Entity create();
+	// Return the index of e to the free list, does nothing for the null handle or a stale handle
+	static void release(Entity e);
+	// Whether e is the current handle of its index, i.e. it was created and not released since
+	static bool alive(Entity e);
+
+	unsigned int index() const { return id & INDEX_MASK; }
+	unsigned int generation() const { return id >> INDEX_BITS; }
+	operator unsigned int() const { return id; } // this enables automatic casting to int
+};
+
+// Bitmask of the containers holding a component of an entity, see ComponentContainer::track_signature
+using Signature = uint64_t;
+
+// Allocator for arrays that SIMD kernels load with aligned instructions
+template <typename T, size_t Alignment>
+struct AlignedAllocator
+{
+	using value_type = T;
+	template <typename U>
+	struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+	AlignedAllocator() = default;
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	T* allocate(size_t n)
+	{
+		// Over-allocate and keep the pointer returned by malloc just in front of the aligned block
+		void* raw = std::malloc(n * sizeof(T) + Alignment);
+		if (raw == nullptr) throw std::bad_alloc();
+		uintptr_t aligned = ((uintptr_t)raw + Alignment) & ~(uintptr_t)(Alignment - 1);
+		((void**)aligned)[-1] = raw;
+		return (T*)aligned;
+	}
+	void deallocate(T* p, size_t)
+	{
+		std::free(((void**)p)[-1]);
+	}
+	template <typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+	template <typename U>
+	bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+// A compile-time list of component types
+template <typename... Components>
+struct type_list {};
+
+// Opt-in structure-of-arrays storage of a component type. By default a container keeps whole
+// components in one array. A specialization lists the member types in 'fields' and names a
+// 'reference' struct, whose members are references to one entry of each field array (in the same
+// order), convertible to the component and assignable from it. The container then stores every
+// member in its own aligned array and hands out references instead of Component&, see
+// ComponentContainer::field for the packed arrays. Specialized for Position in components.hpp.
+template <typename Component>
+struct soa_layout
+{
+	using fields = void;
+};
+
+// The packed values of one field, indexed like the entities of the container
+template <typename T>
+struct FieldSpan
+{
+	T* data;
+	size_t size;
+	T& operator[](size_t i) const { return data[i]; }
+	T* begin() const { return data; }
+	T* end() const { return data + size; }
+};
+
+// Storage of a soa_layout component: one aligned array per field, with the interface of the
+// std::vector used by the default layout (operator[] and back() return a soa_layout<>::reference)
+template <typename Component, typename Fields>
+class SoaArray;
+
+template <typename Component, typename... Fields>
+class SoaArray<Component, type_list<Fields...>>
+{
+	std::tuple<std::vector<Fields, AlignedAllocator<Fields, 32>>...> arrays;
+
+	template <size_t... I>
+	typename soa_layout<Component>::reference at(size_t i, std::index_sequence<I...>)
+	{
+		return { std::get<I>(arrays)[i]... };
+	}
+
+public:
+	using value_type = Component;
+	using reference = typename soa_layout<Component>::reference;
+
+	// What try_get returns, nullptr or a reference to dereference
+	class pointer
+	{
+		SoaArray* array;
+		size_t index;
+
+		struct arrow
+		{
+			reference ref;
+			reference* operator->() { return &ref; }
+		};
+
+	public:
+		pointer(std::nullptr_t) : array(nullptr), index(0) {}
+		pointer(SoaArray* array, size_t index) : array(array), index(index) {}
+		reference operator*() const { return (*array)[index]; }
+		arrow operator->() const { return { **this }; }
+		explicit operator bool() const { return array != nullptr; }
+		bool operator==(std::nullptr_t) const { return array == nullptr; }
+		bool operator!=(std::nullptr_t) const { return array != nullptr; }
+	};
+
+	reference operator[](size_t i) { return at(i, std::index_sequence_for<Fields...>{}); }
+	reference back() { return (*this)[size() - 1]; }
+	pointer address(size_t i) { return pointer(this, i); }
+
+	template <size_t F>
+	typename std::tuple_element<F, std::tuple<Fields...>>::type* field() { return std::get<F>(arrays).data(); }
+
+	size_t size() const { return std::get<0>(arrays).size(); }
+	bool empty() const { return size() == 0; }
+	size_t capacity() const { return std::get<0>(arrays).capacity(); }
+
+	void push_back(const Component& c)
+	{
+		resize(size() + 1);
+		back() = c;
+	}
+	void pop_back() { resize(size() - 1); }
+	void resize(size_t n) { resize(n, std::index_sequence_for<Fields...>{}); }
+	void reserve(size_t n) { reserve(n, std::index_sequence_for<Fields...>{}); }
+	void clear() { resize(0); }
+
+private:
+	template <size_t... I>
+	void resize(size_t n, std::index_sequence<I...>)
+	{
+		using expander = int[];
+		(void)expander{ 0, (std::get<I>(arrays).resize(n), 0)... };
+	}
+	template <size_t... I>
+	void reserve(size_t n, std::index_sequence<I...>)
 	{
-		id = id_count++;
-		// Note, indices of already deleted entities arent re-used in this simple implementation.
+		using expander = int[];
+		(void)expander{ 0, (std::get<I>(arrays).reserve(n), 0)... };
 	}
-	operator unsigned int() { return id; } // this enables automatic casting to int
 };
 
-// Common interface to refer to all containers in the ECS registry
-struct ContainerInterface
+// Address of components[i] for either storage
+template <typename Component>
+Component* component_address(std::vector<Component>& components, size_t i)
 {
-	virtual void clear() = 0;
-	virtual size_t size() = 0;
-	virtual void remove(Entity e) = 0;
-	virtual bool has(Entity entity) = 0;
+	return &components[i];
+}
+template <typename Component, typename Fields>
+typename SoaArray<Component, Fields>::pointer component_address(SoaArray<Component, Fields>& components, size_t i)
+{
+	return components.address(i);
+}
+
+// Receives the structural changes of the containers a Group spans (see Group below)
+struct GroupHandler
+{
+	virtual void on_insert(Entity e) = 0; // after e got a component
+	virtual void on_remove(Entity e) = 0; // before e loses a component
+	virtual void on_clear() = 0;
 };
 
 // A container that stores components of type 'Component' and associated entities
+// Storage is a sparse set: 'components' and 'entities' are dense, packed arrays and a paged sparse
+// index maps an entity id to its position in them, so lookups are two array reads and no hashing.
 template <typename Component> // A component can be any class
-class ComponentContainer : public ContainerInterface
+class ComponentContainer
 {
 private:
-	// The hash map from Entity -> array index.
-	std::unordered_map<unsigned int, unsigned int> map_entity_componentID; // the entity is cast to uint to be hashable.
+	// The sparse index from Entity index -> array index, allocated in pages of SPARSE_PAGE_SIZE ids on first use
+	enum : unsigned int { SPARSE_PAGE_SIZE = 4096, INVALID_INDEX = ~0u };
+	std::vector<std::vector<unsigned int>> sparse_pages;
 	bool registered = false;
+	size_t high_water = 0;
+	bool sorting = false; // the entities are being permuted, the sparse index is what's still valid
+
+	// Opt-in change tracking: the revision at which the component of an entity was inserted or last
+	// patched, indexed by entity index. The revision increases with every change to the container.
+	bool tracking_changes = false;
+	uint64_t current_revision = 0;
+	std::vector<uint64_t> versions;
+
+	void stamp(unsigned int index)
+	{
+		if (versions.size() <= index)
+			versions.resize(index + 1);
+		versions[index] = ++current_revision;
+	}
+
+	// Groups spanning this container, and the one (if any) that owns its order
+	std::vector<GroupHandler*> groups;
+	GroupHandler* owning_group = nullptr;
+
+	// Signature table of the registry and the bit of this container in it
+	std::vector<Signature>* signatures = nullptr;
+	Signature signature_bit = 0;
+
+	unsigned int* sparse_slot(unsigned int id)
+	{
+		unsigned int page = id / SPARSE_PAGE_SIZE;
+		if (page >= sparse_pages.size() || sparse_pages[page].empty())
+			return nullptr;
+		return &sparse_pages[page][id % SPARSE_PAGE_SIZE];
+	}
+
+	unsigned int& assure_sparse_slot(unsigned int id)
+	{
+		unsigned int page = id / SPARSE_PAGE_SIZE;
+		if (page >= sparse_pages.size())
+			sparse_pages.resize(page + 1);
+		if (sparse_pages[page].empty())
+			sparse_pages[page].assign(SPARSE_PAGE_SIZE, INVALID_INDEX);
+		return sparse_pages[page][id % SPARSE_PAGE_SIZE];
+	}
+
 public:
+	// Whole components by default, one array per field for a soa_layout component
+	using storage = typename std::conditional<std::is_void<typename soa_layout<Component>::fields>::value,
+		std::vector<Component>, SoaArray<Component, typename soa_layout<Component>::fields>>::type;
+	// Component& and Component* by default, see soa_layout
+	using reference = typename storage::reference;
+	using pointer = typename storage::pointer;
+
 	// Container of all components of type 'Component'
-	std::vector<Component> components;
+	storage components;
 
 	// The corresponding entities
 	std::vector<Entity> entities;
@@ -52,36 +275,138 @@ public:
 	}
 
 	// Inserting a component c associated to entity e
-	inline Component& insert(Entity e, Component c, bool check_for_duplicates = true)
+	inline reference insert(Entity e, Component c, bool check_for_duplicates = true)
 	{
 		// Usually, every entity should only have one instance of each component type
 		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
 
-		map_entity_componentID[e] = (unsigned int)components.size();
+		// A component left behind by a released entity with the same index can't be reached anymore, drop it
+		unsigned int stale = assure_sparse_slot(e.index());
+		if (stale != INVALID_INDEX && entities[stale] != e)
+			remove(entities[stale]);
+
+		assure_sparse_slot(e.index()) = (unsigned int)components.size();
 		components.push_back(std::move(c)); // the move enforces move instead of copy constructor
 		entities.push_back(e);
-		return components.back();
+		high_water = std::max(high_water, components.size());
+		if (tracking_changes)
+			stamp(e.index());
+		if (signatures) {
+			if (signatures->size() <= e.index())
+				signatures->resize(e.index() + 1);
+			(*signatures)[e.index()] |= signature_bit;
+		}
+		if (groups.empty())
+			return components.back();
+		// Groups may move the new component into their packed range
+		for (GroupHandler* group : groups)
+			group->on_insert(e);
+		return components[*sparse_slot(e.index())];
 	};
 
 	// The emplace function takes the the provided arguments Args, creates a new object of type Component, and inserts it into the ECS system
 	template<typename... Args>
-	Component& emplace(Entity e, Args &&... args) {
+	reference emplace(Entity e, Args &&... args) {
 		return insert(e, Component(std::forward<Args>(args)...));
 	};
 	template<typename... Args>
-	Component& emplace_with_duplicates(Entity e, Args &&... args) {
+	reference emplace_with_duplicates(Entity e, Args &&... args) {
 		return insert(e, Component(std::forward<Args>(args)...), false);
 	};
 
 	// A wrapper to return the component of an entity
-	Component& get(Entity e) {
+	reference get(Entity e) {
+		assert(has(e) && "Entity not contained in ECS registry");
+		return components[*sparse_slot(e.index())];
+	}
+
+	// Like get, but returns nullptr instead of asserting if the entity has no such component
+	pointer try_get(Entity e) {
+		if (!has(e))
+			return nullptr;
+		return component_address(components, *sparse_slot(e.index()));
+	}
+
+	// Position of the component of e in the dense arrays, e must be contained
+	unsigned int index_of(Entity e) {
 		assert(has(e) && "Entity not contained in ECS registry");
-		return components[map_entity_componentID[e]];
+		return *sparse_slot(e.index());
 	}
 
-	// Check if entity has a component of type 'Component'
+	// Swap two components (and their entities) in the dense arrays
+	void swap_entries(unsigned int i, unsigned int j) {
+		if (i == j) return;
+		Component c = std::move(components[i]);
+		components[i] = std::move(components[j]);
+		components[j] = std::move(c);
+		std::swap(entities[i], entities[j]);
+		*sparse_slot(entities[i].index()) = i;
+		*sparse_slot(entities[j].index()) = j;
+	}
+
+	// Start tracking changes. Writers then announce modifications through patch or touch, get stays
+	// the plain access so reading doesn't count as a change.
+	void track_changes() {
+		tracking_changes = true;
+	}
+
+	// Mutable access that marks the component of e as changed
+	reference patch(Entity e) {
+		reference c = get(e);
+		touch(e);
+		return c;
+	}
+
+	// Mark the component of e as changed, for writes done through get() or the packed fields
+	void touch(Entity e) {
+		if (tracking_changes)
+			stamp(e.index());
+	}
+
+	// Increases with every insert, patch, touch and removal, remember it to ask what changed since
+	uint64_t revision() const {
+		return current_revision;
+	}
+
+	// The revision of the last change to the component of e, 0 if changes aren't tracked
+	uint64_t version(Entity e) const {
+		return e.index() < versions.size() ? versions[e.index()] : 0;
+	}
+
+	bool changed(Entity e, uint64_t since) const {
+		return version(e) > since;
+	}
+
+	// Calls func(Entity, reference) for each component inserted or changed after revision 'since'
+	template <class Func>
+	void each_changed(uint64_t since, Func func) {
+		for (unsigned int i = 0; i < entities.size(); i++)
+			if (version(entities[i]) > since)
+				func(entities[i], components[i]);
+	}
+
+	// Keep 'bit' of table[e.index()] set while the container holds a component of e
+	void track_signature(std::vector<Signature>& table, unsigned int bit) {
+		assert(bit < 64 && entities.empty() && "Signatures are tracked from the start, 64 containers at most");
+		signatures = &table;
+		signature_bit = Signature(1) << bit;
+	}
+
+	Signature signature() const {
+		return signature_bit;
+	}
+
+	// Register a group that spans this container, 'owning' groups get to rearrange it
+	void attach_group(GroupHandler* group, bool owning) {
+		assert(!(owning && owning_group != nullptr) && "A container can only be owned by one group");
+		groups.push_back(group);
+		if (owning) owning_group = group;
+	}
+
+	// Check if entity has a component of type 'Component', stale handles of a released entity never match
 	bool has(Entity entity) {
-		return map_entity_componentID.count(entity) > 0;
+		unsigned int* slot = sparse_slot(entity.index());
+		return slot != nullptr && *slot != INVALID_INDEX && (sorting || entities[*slot] == entity);
 	}
 
 	// Remove an component and pack the container to re-use the empty space
@@ -89,29 +414,53 @@ public:
 	{
 		if (has(e))
 		{
+			for (GroupHandler* group : groups)
+				group->on_remove(e);
+
 			// Get the current position
-			int cID = map_entity_componentID[e];
+			unsigned int cID = *sparse_slot(e.index());
 
 			// Move the last element to position cID using the move operator
 			// Note, components[cID] = components.back() would trigger the copy instead of move operator
 			components[cID] = std::move(components.back());
 			entities[cID] = entities.back(); // the entity is only a single index, copy it.
-			map_entity_componentID[entities.back()] = cID;
+			*sparse_slot(entities.back().index()) = cID;
 
 			// Erase the old component and free its memory
-			map_entity_componentID.erase(e);
+			*sparse_slot(e.index()) = INVALID_INDEX;
 			components.pop_back();
 			entities.pop_back();
-			// Note, one could mark the id for re-use
+			if (signatures)
+				(*signatures)[e.index()] &= ~signature_bit;
+			if (tracking_changes)
+				current_revision++;
 		}
 	};
 
 	// Remove all components of type 'Component'
 	void clear()
 	{
-		map_entity_componentID.clear();
+		// Only the touched slots are reset, the pages are kept for re-use
+		for (Entity e : entities) {
+			*sparse_slot(e.index()) = INVALID_INDEX;
+			if (signatures)
+				(*signatures)[e.index()] &= ~signature_bit;
+		}
 		components.clear();
 		entities.clear();
+		if (tracking_changes)
+			current_revision++;
+		for (GroupHandler* group : groups)
+			group->on_clear();
+	}
+
+	// The packed array of field F of a soa_layout component, e.g. positions.field<soa_layout<Position>::SCALE>().
+	// Indexed like 'entities', valid until the next insertion or removal.
+	template <size_t F>
+	auto field()
+	{
+		auto data = components.template field<F>();
+		return FieldSpan<typename std::remove_pointer<decltype(data)>::type>{ data, components.size() };
 	}
 
 	// Report the number of components of type 'Component'
@@ -120,18 +469,604 @@ public:
 		return components.size();
 	}
 
+	// The largest size reached so far. Removing never gives memory back, so after the peak the
+	// container inserts without allocating.
+	size_t peak() const
+	{
+		return high_water;
+	}
+
+	size_t capacity() const
+	{
+		return components.capacity();
+	}
+
+	// Make room for n components, inserting up to n doesn't reallocate
+	void reserve(size_t n)
+	{
+		components.reserve(n);
+		entities.reserve(n);
+	}
+
 	// Sort the components and associated entity assignment structures by the comparisonFunction, see std::sort
+	// (comparisonFunction compares entities, get() is valid inside it). Sorts in place without allocating.
 	template <class Compare>
 	void sort(Compare comparisonFunction)
 	{
+		assert(owning_group == nullptr && "The order of this container is owned by a group");
 		// First sort the entity list as desired
+		sorting = true;
 		std::sort(entities.begin(), entities.end(), comparisonFunction);
-		// Now re-arrange the components (Note, creates a new vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap)
-		std::vector<Component> components_new; components_new.reserve(components.size());
-		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(get(e)); }); // note, the get still uses the old hash map (on purpose!)
-		components = std::move(components_new); // note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
-		// Fill the new hashmap
-		for (unsigned int i = 0; i < entities.size(); i++)
-			map_entity_componentID[entities[i]] = i;
+		sorting = false;
+		follow_entities();
+	}
+
+	// As sort, but entities that compare equal keep their order, see std::stable_sort (which may allocate)
+	template <class Compare>
+	void stable_sort(Compare comparisonFunction)
+	{
+		assert(owning_group == nullptr && "The order of this container is owned by a group");
+		sorting = true;
+		std::stable_sort(entities.begin(), entities.end(), comparisonFunction);
+		sorting = false;
+		follow_entities();
+	}
+
+	// Apply the permutation of the entity list to the components by walking its cycles. Until an entity is
+	// placed its sparse slot still holds the old position of its component, i.e. where to move from.
+	void follow_entities()
+	{
+		for (unsigned int i = 0; i < entities.size(); i++) {
+			unsigned int from = *sparse_slot(entities[i].index());
+			if (from == i)
+				continue;
+			Component displaced = std::move(components[i]);
+			unsigned int to = i;
+			while (from != i) {
+				components[to] = std::move(components[from]);
+				*sparse_slot(entities[to].index()) = to;
+				to = from;
+				from = *sparse_slot(entities[to].index());
+			}
+			components[to] = std::move(displaced);
+			*sparse_slot(entities[to].index()) = to;
+		}
+	}
+
+	// Stable sort by key(const Component&), for containers that stay almost sorted from one call to the
+	// next. An insertion pass costs O(n + misplaced pairs), if that grows past a few moves per element
+	// the rest is left to stable_sort().
+	template <class Key>
+	void sort_by_key(Key key)
+	{
+		assert(owning_group == nullptr && "The order of this container is owned by a group");
+		size_t budget = 4 * components.size() + 32;
+		for (unsigned int i = 1; i < components.size(); i++) {
+			auto k = key(components[i]);
+			if (!(k < key(components[i - 1])))
+				continue;
+			Component c = std::move(components[i]);
+			Entity e = entities[i];
+			unsigned int j = i;
+			for (; j > 0 && k < key(components[j - 1]); j--) {
+				components[j] = std::move(components[j - 1]);
+				entities[j] = entities[j - 1];
+				*sparse_slot(entities[j].index()) = j;
+			}
+			components[j] = std::move(c);
+			entities[j] = e;
+			*sparse_slot(e.index()) = j;
+			if (i - j > budget) {
+				stable_sort([&](Entity a, Entity b) { return key(get(a)) < key(get(b)); });
+				return;
+			}
+			budget -= i - j;
+		}
+	}
+};
+
+// Component types a View skips, e.g. registry.view<RenderRequest, Position>(exclude<Text, Shadow>)
+template <typename... Excluded>
+struct exclude_t {};
+template <typename... Excluded>
+constexpr exclude_t<Excluded...> exclude{};
+
+// Iterates all entities that have every 'Included' and none of the 'Excluded' components.
+// Iteration is driven by the smallest included container (or the one chosen with use<T>() when the
+// order matters), so entities missing a component are rejected with one sparse lookup each.
+template <typename Included, typename Excluded>
+class View;
+
+template <typename... Included, typename... Excluded>
+class View<type_list<Included...>, type_list<Excluded...>>
+{
+	std::tuple<ComponentContainer<Included>*...> included;
+	std::tuple<ComponentContainer<Excluded>*...> excluded;
+	std::vector<Entity>* driver;
+
+	bool excluded_any(Entity e)
+	{
+		(void)e; // unused without excluded types
+		bool any = false;
+		using expander = int[];
+		(void)expander{ 0, (any = any || std::get<ComponentContainer<Excluded>*>(excluded)->has(e), 0)... };
+		return any;
+	}
+
+	template <class Func, size_t... I>
+	void each_impl(Func& func, std::index_sequence<I...>)
+	{
+		for (size_t i = 0; i < driver->size();) {
+			Entity e = (*driver)[i];
+			// One sparse lookup per included container, a missing component yields nullptr
+			std::tuple<typename ComponentContainer<Included>::pointer...> found(std::get<I>(included)->try_get(e)...);
+			bool all = true;
+			using expander = int[];
+			(void)expander{ 0, (all = all && std::get<I>(found) != nullptr, 0)... };
+			if (all && !excluded_any(e))
+				func(e, *std::get<I>(found)...);
+			// If func removed e, the last entity was moved into slot i and is visited next
+			if (i < driver->size() && (*driver)[i] == e)
+				i++;
+		}
+	}
+
+public:
+	View(ComponentContainer<Included>&... included_containers, ComponentContainer<Excluded>&... excluded_containers)
+		: included(&included_containers...), excluded(&excluded_containers...)
+	{
+		driver = nullptr;
+		using expander = int[];
+		(void)expander{ 0, ((driver == nullptr || included_containers.entities.size() < driver->size())
+			? (driver = &included_containers.entities, 0) : 0)... };
+	}
+
+	// Drive the iteration (and hence its order) by the container of 'Component'
+	template <typename Component>
+	View& use()
+	{
+		driver = &std::get<ComponentContainer<Component>*>(included)->entities;
+		return *this;
+	}
+
+	// Upper bound on the number of entities the view yields
+	size_t size_hint() const
+	{
+		return driver->size();
+	}
+
+	// Calls func(Entity, Included&...) for each matching entity (soa_layout components are passed by their
+	// reference type), in the order of the driving container.
+	// func may remove the current entity, but should not remove others (defer those instead).
+	template <class Func>
+	void each(Func func)
+	{
+		each_impl(func, std::index_sequence_for<Included...>{});
+	}
+};
+
+// A persistent group of all entities that have every 'Owned' and 'Observed' component.
+// The owned containers keep the members packed at the front of their dense arrays, in the same order,
+// so iterating a group is a lockstep linear walk over components[0..size()) of each owned container.
+// Membership is updated incrementally as components are inserted and removed; observed components are
+// looked up per entity. A container can be owned by at most one group, and can't be sorted once owned.
+template <typename Owned, typename Observed = type_list<>>
+class Group;
+
+template <typename... Owned, typename... Observed>
+class Group<type_list<Owned...>, type_list<Observed...>> : public GroupHandler
+{
+	std::tuple<ComponentContainer<Owned>*...> owned;
+	std::tuple<ComponentContainer<Observed>*...> observed;
+	unsigned int length = 0;
+
+	using lead_type = typename std::tuple_element<0, std::tuple<Owned...>>::type;
+	ComponentContainer<lead_type>& lead() { return *std::get<0>(owned); }
+
+	bool has_all(Entity e)
+	{
+		bool all = true;
+		using expander = int[];
+		(void)expander{ 0, (all = all && std::get<ComponentContainer<Owned>*>(owned)->has(e), 0)... };
+		(void)expander{ 0, (all = all && std::get<ComponentContainer<Observed>*>(observed)->has(e), 0)... };
+		return all;
+	}
+
+public:
+	Group(ComponentContainer<Owned>&... owned_containers, ComponentContainer<Observed>&... observed_containers)
+		: owned(&owned_containers...), observed(&observed_containers...)
+	{
+		using expander = int[];
+		(void)expander{ 0, (owned_containers.attach_group(this, true), 0)... };
+		(void)expander{ 0, (observed_containers.attach_group(this, false), 0)... };
+		for (unsigned int i = 0; i < lead().entities.size(); i++)
+			on_insert(lead().entities[i]);
+	}
+
+	// Groups hold pointers to the containers and are registered with them, they can't be copied
+	Group(const Group&) = delete;
+	Group& operator=(const Group&) = delete;
+
+	bool contains(Entity e)
+	{
+		return lead().has(e) && lead().index_of(e) < length;
+	}
+
+	void on_insert(Entity e) override
+	{
+		if (contains(e) || !has_all(e)) return;
+		using expander = int[];
+		(void)expander{ 0, (std::get<ComponentContainer<Owned>*>(owned)->swap_entries(
+			std::get<ComponentContainer<Owned>*>(owned)->index_of(e), length), 0)... };
+		length++;
+	}
+
+	void on_remove(Entity e) override
+	{
+		if (!contains(e)) return;
+		length--;
+		using expander = int[];
+		(void)expander{ 0, (std::get<ComponentContainer<Owned>*>(owned)->swap_entries(
+			std::get<ComponentContainer<Owned>*>(owned)->index_of(e), length), 0)... };
+	}
+
+	void on_clear() override
+	{
+		length = 0;
+	}
+
+	// Number of members, they are lead().entities[0..size())
+	size_t size() const
+	{
+		return length;
+	}
+
+	Entity entity(size_t i)
+	{
+		return lead().entities[i];
+	}
+
+	// Calls func(Entity, Owned&..., Observed&...) for each member. Don't add or remove components of
+	// the group's types from within func, that reorders the packed range.
+	template <class Func>
+	void each(Func func)
+	{
+		for (unsigned int i = 0; i < length; i++)
+			func(lead().entities[i], std::get<ComponentContainer<Owned>*>(owned)->components[i]...,
+				std::get<ComponentContainer<Observed>*>(observed)->get(lead().entities[i])...);
+	}
+};
+
+// Structural changes recorded while systems iterate containers, applied in one batch by flush().
+// Removing an entity mid-loop swaps another one into the current slot, recording it instead keeps
+// the iteration intact. Destroyed entities stay fully valid until the flush.
+// All queues keep their storage from one flush to the next, so once they have grown to the
+// frame's peak recording doesn't allocate.
+class CommandBuffer
+{
+	std::vector<Entity> destroyed;
+	std::vector<Entity> pending; // indexed by entity index, the handle queued for destruction
+
+	// The insertions into one container, the components are stored by value in a typed array
+	struct InsertQueue
+	{
+		void* container;
+		virtual ~InsertQueue() = default;
+		virtual bool empty() const = 0;
+		virtual void apply() = 0;
+	};
+
+	template <typename Component>
+	struct TypedInsertQueue : InsertQueue
+	{
+		std::vector<std::pair<Entity, Component>> entries;
+
+		bool empty() const override
+		{
+			return entries.empty();
+		}
+
+		void apply() override
+		{
+			auto* target = static_cast<ComponentContainer<Component>*>(container);
+			for (auto& entry : entries)
+				if (Entity::alive(entry.first) && !target->has(entry.first))
+					target->insert(entry.first, std::move(entry.second));
+			entries.clear();
+		}
+	};
+
+	// One queue per container inserted into so far, applied in that order
+	std::vector<std::unique_ptr<InsertQueue>> added;
+
+	template <typename Component>
+	TypedInsertQueue<Component>& insert_queue(ComponentContainer<Component>& container)
+	{
+		for (auto& queue : added)
+			if (queue->container == &container)
+				return static_cast<TypedInsertQueue<Component>&>(*queue);
+		added.emplace_back(new TypedInsertQueue<Component>());
+		added.back()->container = &container;
+		return static_cast<TypedInsertQueue<Component>&>(*added.back());
+	}
+
+	// A removal from a container of any type, sequence is the order of recording
+	struct Removal
+	{
+		void* container;
+		void (*remove)(void* container, Entity e);
+		Entity e;
+		unsigned int sequence;
+	};
+	std::vector<Removal> removed;
+
+	template <typename Component>
+	static void remove_from(void* container, Entity e)
+	{
+		static_cast<ComponentContainer<Component>*>(container)->remove(e);
+	}
+
+public:
+	// Remove all components of e and release its handle at the next flush
+	void destroy(Entity e)
+	{
+		if (e == Entity() || is_destroyed(e))
+			return;
+		if (pending.size() <= e.index())
+			pending.resize(e.index() + 1);
+		pending[e.index()] = e;
+		destroyed.push_back(e);
+	}
+
+	bool is_destroyed(Entity e) const
+	{
+		return e != Entity() && e.index() < pending.size() && pending[e.index()] == e;
+	}
+
+	template <typename Component>
+	void remove(ComponentContainer<Component>& container, Entity e)
+	{
+		removed.push_back({ &container, &remove_from<Component>, e, (unsigned int)removed.size() });
+	}
+
+	// The component is stored now and inserted at the flush, unless e is gone or already has one by then
+	template <typename Component>
+	void insert(ComponentContainer<Component>& container, Entity e, Component c)
+	{
+		insert_queue(container).entries.emplace_back(e, std::move(c));
+	}
+
+	template <typename Component, typename... Args>
+	void emplace(ComponentContainer<Component>& container, Entity e, Args&&... args)
+	{
+		insert(container, e, Component(std::forward<Args>(args)...));
+	}
+
+	bool empty() const
+	{
+		for (auto& queue : added)
+			if (!queue->empty())
+				return false;
+		return destroyed.empty() && removed.empty();
+	}
+
+	// Apply everything recorded since the last flush. Additions go first so that a removal or
+	// destruction recorded in the same frame wins. The entities to destroy are handed over in one
+	// batch, destroy_batch(const std::vector<Entity>&) removes their components and releases them.
+	template <class DestroyBatch>
+	void flush(DestroyBatch destroy_batch)
+	{
+		for (auto& queue : added)
+			queue->apply();
+		// Grouped by container, in recording order within each. The sequence makes the order total,
+		// so the in-place sort gives the stable result without stable_sort's buffer.
+		std::sort(removed.begin(), removed.end(), [](const Removal& a, const Removal& b) {
+			return a.container != b.container ? std::less<void*>()(a.container, b.container) : a.sequence < b.sequence;
+		});
+		for (Removal& r : removed)
+			r.remove(r.container, r.e);
+		if (!destroyed.empty()) {
+			destroy_batch(destroyed);
+			for (Entity e : destroyed)
+				pending[e.index()] = Entity();
+		}
+		removed.clear();
+		destroyed.clear();
+	}
+};
+
+// Position of T in Ts..., fails to compile if T is not in the list
+template <typename T, typename... Ts>
+struct type_position;
+template <typename T, typename... Ts>
+struct type_position<T, T, Ts...> : std::integral_constant<unsigned int, 0> {};
+template <typename T, typename U, typename... Ts>
+struct type_position<T, U, Ts...> : std::integral_constant<unsigned int, 1 + type_position<T, Ts...>::value> {};
+
+// A registry with one container per type in Components, a component type is added in that list only.
+// Operations over all containers are pack expansions, a straight sequence of inlinable calls with no
+// virtual dispatch. Bit i of an entity's signature belongs to the i-th component type.
+template <typename... Components>
+class Registry
+{
+	static_assert(sizeof...(Components) <= 64, "A signature has one bit per component type");
+	using expander = int[];
+
+	std::tuple<ComponentContainer<Components>...> containers;
+	std::vector<Signature> signatures;
+	Signature persistent = 0; // components kept by remove_all_components_of and clear_all_components
+	std::vector<Entity> retired; // removed while kept components still hold them, see retire
+
+	// Recycle the index of a removed entity, unless kept or persistent components still hold it: a new
+	// entity would inherit them. Those wait in retired until their last component is gone.
+	void retire(Entity e)
+	{
+		if (signature(e) == 0)
+			Entity::release(e);
+		else
+			retired.push_back(e);
+	}
+
+	template <typename Component>
+	void remove_if_in(Signature mask, Entity e)
+	{
+		if (mask & signature_of<Component>())
+			get<Component>().remove(e);
+	}
+
+	template <typename Component>
+	void remove_batch_if_in(Signature mask, const std::vector<Entity>& batch)
+	{
+		if (mask & signature_of<Component>())
+			for (Entity e : batch)
+				get<Component>().remove(e);
+	}
+
+	template <typename Component>
+	void clear_unless_in(Signature mask)
+	{
+		if (!(mask & signature_of<Component>()))
+			get<Component>().clear();
+	}
+
+protected:
+	// Exclude the given components from the whole-entity and whole-registry removals
+	template <typename... Kept>
+	void persist()
+	{
+		persistent |= signature_of<Kept...>();
+	}
+
+public:
+	// Structural changes requested while iterating, applied by flush_commands() once per frame
+	CommandBuffer commands;
+
+	Registry()
+	{
+		(void)expander{ 0, (get<Components>().track_signature(signatures, type_position<Components, Components...>::value), 0)... };
+	}
+
+	// The containers point into the signature table, groups point at the containers
+	Registry(const Registry&) = delete;
+	Registry& operator=(const Registry&) = delete;
+
+	// The container storing components of type 'Component'
+	template <typename Component>
+	ComponentContainer<Component>& get()
+	{
+		return std::get<ComponentContainer<Component>>(containers);
+	}
+
+	// The mask of the given component types, e.g. signature_of<Position, Velocity>()
+	template <typename... Cs>
+	static Signature signature_of()
+	{
+		Signature mask = 0;
+		(void)expander{ 0, (mask |= Signature(1) << type_position<Cs, Components...>::value, 0)... };
+		return mask;
+	}
+
+	// The components of e, only meaningful while e is alive (the table is indexed by entity index
+	// and a recycled index belongs to the new entity)
+	Signature signature(Entity e) const
+	{
+		return e.index() < signatures.size() ? signatures[e.index()] : 0;
+	}
+
+	// Whether e has all 'Included' and none of the 'Excluded' components, a single mask test
+	// e.g. registry.matches<Enemy, Velocity>(e, exclude<Boss>)
+	template <typename... Included, typename... Excluded>
+	bool matches(Entity e, exclude_t<Excluded...>)
+	{
+		Signature included = signature_of<Included...>();
+		Signature sig = signature(e);
+		return (sig & included) == included && !(sig & signature_of<Excluded...>());
+	}
+
+	template <typename... Included>
+	bool matches(Entity e)
+	{
+		Signature included = signature_of<Included...>();
+		return (signature(e) & included) == included;
+	}
+
+	// Query all entities with the 'Included' components, e.g. registry.view<Position, Velocity>()
+	// or registry.view<RenderRequest, Position>(exclude<Text, Shadow, Floor>)
+	template <typename... Included, typename... Excluded>
+	View<type_list<Included...>, type_list<Excluded...>> view(exclude_t<Excluded...>)
+	{
+		return View<type_list<Included...>, type_list<Excluded...>>(get<Included>()..., get<Excluded>()...);
+	}
+
+	template <typename... Included>
+	View<type_list<Included...>, type_list<>> view()
+	{
+		return View<type_list<Included...>, type_list<>>(get<Included>()...);
+	}
+
+	// Pre-size the containers of the given types, e.g. reserve<Position, Velocity>(256)
+	template <typename... Cs>
+	void reserve(size_t n)
+	{
+		(void)n; // unused for an empty list
+		(void)expander{ 0, (get<Cs>().reserve(n), 0)... };
+	}
+
+	void clear_all_components()
+	{
+		(void)expander{ 0, (clear_unless_in<Components>(persistent), 0)... };
+	}
+
+	void list_all_components()
+	{
+		printf("Debug info on all registry entries:\n");
+		(void)expander{ 0, (get<Components>().peak() > 0 ?
+			printf("%4d components of type %s (peak %d, capacity %d)\n", (int)get<Components>().size(), typeid(Components).name(),
+				(int)get<Components>().peak(), (int)get<Components>().capacity()) : 0)... };
+	}
+
+	void list_all_components_of(Entity e)
+	{
+		printf("Debug info on components of entity %u:\n", (unsigned int)e);
+		Signature sig = signature(e);
+		(void)expander{ 0, ((sig & signature_of<Components>()) ? printf("type %s\n", typeid(Components).name()) : 0)... };
+	}
+
+	// Removing all components destroys the entity, its index is recycled by the next Entity::create().
+	// Only the containers in the signature of e are touched, 'Kept' components are left alone and the
+	// index is only recycled once they are gone too (checked at flush_commands).
+	template <typename... Kept>
+	void remove_all_components_of(Entity e)
+	{
+		Signature mask = signature(e) & ~persistent & ~signature_of<Kept...>();
+		(void)expander{ 0, (remove_if_in<Components>(mask, e), 0)... };
+		retire(e);
+	}
+
+	// The frame's sync point for the command buffer, destroys skip the same components as remove_all_components_of
+	void flush_commands()
+	{
+		commands.flush([this](const std::vector<Entity>& batch) {
+			// Visit only the containers holding one of the entities, one container at a time
+			Signature touched = 0;
+			for (Entity e : batch)
+				touched |= signature(e);
+			touched &= ~persistent;
+			(void)expander{ 0, (remove_batch_if_in<Components>(touched, batch), 0)... };
+			for (Entity e : batch)
+				retire(e);
+		});
+
+		// Release the retired entities whose kept components have been removed since
+		size_t waiting = 0;
+		for (Entity e : retired) {
+			if (!Entity::alive(e))
+				continue;
+			if (signature(e) == 0)
+				Entity::release(e);
+			else
+				retired[waiting++] = e;
+		}
+		retired.resize(waiting);
 	}
 };
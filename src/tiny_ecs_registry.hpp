@@ -4,129 +4,118 @@
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 
-class ECSRegistry
+// All components this game has, each type gets a container in the registry
+class ECSRegistry : public Registry<
+	DeathTimer,
+	WinTimer,
+	WeaknessTimer,
+	Resources,
+	HealthBar,
+	ManaBar,
+	Projectile,
+	CharacterProjectileType,
+	ProjectileSelectDisplay,
+	PowerUpIndicator,
+	Parent,
+	Text,
+	InvulnerableTimer,
+	Position,
+	Velocity,
+	Floor,
+	Direction,
+	Collision,
+	Collidable,
+	Player,
+	Enemy,
+	Boss,
+	LostSoul,
+	PowerUp,
+	PowerUpBlock,
+	Terrain,
+	HealthPack,
+	Shadow,
+	ExitDoor,
+	LifeOrb,
+	Cutscene,
+	Mesh*,
+	SpriteSheet*,
+	Animation,
+	RenderRequest,
+	ScreenState,
+	DebugComponent,
+	vec3,
+	Obstacle,
+	Sleeping,
+	AILod>
 {
-	// Callbacks to remove a particular or all entities in the system
-	std::vector<ContainerInterface*> registry_list;
-
 public:
-	// Manually created list of all components this game has
-	ComponentContainer<DeathTimer> deathTimers;
-	ComponentContainer<WinTimer> winTimers;
-	ComponentContainer<WeaknessTimer> weaknessTimers;
-	ComponentContainer<Resources> resources;
-	ComponentContainer<HealthBar> healthBars;
-	ComponentContainer<ManaBar> manaBars;
-	ComponentContainer<Projectile> projectiles;
-	ComponentContainer<CharacterProjectileType> characterProjectileTypes;
-	ComponentContainer<ProjectileSelectDisplay> projectileSelectDisplays;
-	ComponentContainer<PowerUpIndicator> powerUpIndicators;
-	ComponentContainer<Follower> followers;
-	ComponentContainer<SecondaryFollower> secondaryFollowers;
-	ComponentContainer<Text> texts;
-	ComponentContainer<InvulnerableTimer> invulnerableTimers;
-	ComponentContainer<Position> positions;
-	ComponentContainer<Velocity> velocities;
-	ComponentContainer<Floor> floors;
-	ComponentContainer<Direction> directions;
-	ComponentContainer<Collision> collisions;
-	ComponentContainer<Collidable> collidables;
-	ComponentContainer<Player> players;
-	ComponentContainer<Enemy> enemies;
-	ComponentContainer<Boss> bosses;
-	ComponentContainer<LostSoul> lostSouls;
-	ComponentContainer<PowerUp> powerUps;
-	ComponentContainer<PowerUpBlock> powerUpBlocks;
-	ComponentContainer<Terrain> terrain;
-	ComponentContainer<HealthPack> healthPacks;
-	ComponentContainer<Shadow> shadows;
-	ComponentContainer<ExitDoor> exitDoors;
-	ComponentContainer<LifeOrb> lifeOrbs;
-	ComponentContainer<Cutscene> cutscenes;
-	ComponentContainer<Mesh*> meshPtrs;
-	ComponentContainer<SpriteSheet*> spriteSheetPtrs;
-	ComponentContainer<Animation> animations;
-	ComponentContainer<RenderRequest> renderRequests;
-	ComponentContainer<ScreenState> screenStates;
-	ComponentContainer<DebugComponent> debugComponents;
-	ComponentContainer<vec3> colors;
-	ComponentContainer<Obstacle> obstacles;
+	// Named access to the containers
+	ComponentContainer<DeathTimer>& deathTimers = get<DeathTimer>();
+	ComponentContainer<WinTimer>& winTimers = get<WinTimer>();
+	ComponentContainer<WeaknessTimer>& weaknessTimers = get<WeaknessTimer>();
+	ComponentContainer<Resources>& resources = get<Resources>();
+	ComponentContainer<HealthBar>& healthBars = get<HealthBar>();
+	ComponentContainer<ManaBar>& manaBars = get<ManaBar>();
+	ComponentContainer<Projectile>& projectiles = get<Projectile>();
+	ComponentContainer<CharacterProjectileType>& characterProjectileTypes = get<CharacterProjectileType>();
+	ComponentContainer<ProjectileSelectDisplay>& projectileSelectDisplays = get<ProjectileSelectDisplay>();
+	ComponentContainer<PowerUpIndicator>& powerUpIndicators = get<PowerUpIndicator>();
+	ComponentContainer<Parent>& parents = get<Parent>();
+	ComponentContainer<Text>& texts = get<Text>();
+	ComponentContainer<InvulnerableTimer>& invulnerableTimers = get<InvulnerableTimer>();
+	ComponentContainer<Position>& positions = get<Position>();
+	ComponentContainer<Velocity>& velocities = get<Velocity>();
+	ComponentContainer<Floor>& floors = get<Floor>();
+	ComponentContainer<Direction>& directions = get<Direction>();
+	ComponentContainer<Collision>& collisions = get<Collision>();
+	ComponentContainer<Collidable>& collidables = get<Collidable>();
+	ComponentContainer<Player>& players = get<Player>();
+	ComponentContainer<Enemy>& enemies = get<Enemy>();
+	ComponentContainer<Boss>& bosses = get<Boss>();
+	ComponentContainer<LostSoul>& lostSouls = get<LostSoul>();
+	ComponentContainer<PowerUp>& powerUps = get<PowerUp>();
+	ComponentContainer<PowerUpBlock>& powerUpBlocks = get<PowerUpBlock>();
+	ComponentContainer<Terrain>& terrain = get<Terrain>();
+	ComponentContainer<HealthPack>& healthPacks = get<HealthPack>();
+	ComponentContainer<Shadow>& shadows = get<Shadow>();
+	ComponentContainer<ExitDoor>& exitDoors = get<ExitDoor>();
+	ComponentContainer<LifeOrb>& lifeOrbs = get<LifeOrb>();
+	ComponentContainer<Cutscene>& cutscenes = get<Cutscene>();
+	ComponentContainer<Mesh*>& meshPtrs = get<Mesh*>();
+	ComponentContainer<SpriteSheet*>& spriteSheetPtrs = get<SpriteSheet*>();
+	ComponentContainer<Animation>& animations = get<Animation>();
+	ComponentContainer<RenderRequest>& renderRequests = get<RenderRequest>();
+	ComponentContainer<ScreenState>& screenStates = get<ScreenState>();
+	ComponentContainer<DebugComponent>& debugComponents = get<DebugComponent>();
+	ComponentContainer<vec3>& colors = get<vec3>();
+	ComponentContainer<Obstacle>& obstacles = get<Obstacle>();
+	ComponentContainer<Sleeping>& sleeping = get<Sleeping>();
+	ComponentContainer<AILod>& aiLods = get<AILod>();
+
+	// Persistent groups of components iterated together every frame, see Group
+	Group<type_list<Position, Velocity>> movers{ positions, velocities }; // integration
+	Group<type_list<Collidable>, type_list<Position>> colliders{ collidables, positions }; // broadphase
+	Group<type_list<Enemy>, type_list<Position, Velocity>> agents{ enemies, positions, velocities }; // AI
 
-	// constructor that adds all containers for looping over them
-	// IMPORTANT: Don't forget to add any newly added containers!
 	ECSRegistry()
 	{
-		registry_list.push_back(&deathTimers);
-		registry_list.push_back(&weaknessTimers);
-		registry_list.push_back(&projectiles);
-		registry_list.push_back(&texts);
-		registry_list.push_back(&resources);
-		registry_list.push_back(&healthBars);
-		registry_list.push_back(&manaBars);
-		registry_list.push_back(&characterProjectileTypes);
-		registry_list.push_back(&projectileSelectDisplays);
-		registry_list.push_back(&powerUpIndicators);
-		registry_list.push_back(&followers);
-		registry_list.push_back(&secondaryFollowers);
-		registry_list.push_back(&invulnerableTimers);
-		registry_list.push_back(&positions);
-		registry_list.push_back(&velocities);
-		registry_list.push_back(&floors);
-		registry_list.push_back(&directions);
-		registry_list.push_back(&collisions);
-		registry_list.push_back(&collidables);
-		registry_list.push_back(&players);
-		registry_list.push_back(&enemies);
-		registry_list.push_back(&bosses);
-		registry_list.push_back(&lostSouls);
-		registry_list.push_back(&powerUps);
-		registry_list.push_back(&powerUpBlocks);
-		registry_list.push_back(&terrain);
-		registry_list.push_back(&healthPacks);
-		registry_list.push_back(&shadows);
-		registry_list.push_back(&exitDoors);
-		registry_list.push_back(&lifeOrbs);
-		registry_list.push_back(&cutscenes);
-		registry_list.push_back(&meshPtrs);
-		registry_list.push_back(&spriteSheetPtrs);
-		registry_list.push_back(&animations);
-		registry_list.push_back(&renderRequests);
-		registry_list.push_back(&screenStates);
-		registry_list.push_back(&debugComponents);
-		registry_list.push_back(&colors);
-		registry_list.push_back(&obstacles);
-	}
-
-	void clear_all_components() {
-		for (ContainerInterface* reg : registry_list)
-			reg->clear();
-	}
-
-	void list_all_components() {
-		printf("Debug info on all registry entries:\n");
-		for (ContainerInterface* reg : registry_list)
-			if (reg->size() > 0)
-				printf("%4d components of type %s\n", (int)reg->size(), typeid(*reg).name());
-	}
-
-	void list_all_components_of(Entity e) {
-		printf("Debug info on components of entity %u:\n", (unsigned int)e);
-		for (ContainerInterface* reg : registry_list)
-			if (reg->has(e))
-				printf("type %s\n", typeid(*reg).name());
-	}
+		// The win timer outlives restart_game, the spotlight animation finishes in the next level
+		persist<WinTimer>();
 
-	void remove_all_components_of(Entity e) {
-		for (ContainerInterface* reg : registry_list)
-			reg->remove(e);
+		// Movement is announced through positions.patch/touch, the renderer caches transforms on it
+		positions.track_changes();
+		// Changes to the draw keys go through renderRequests.patch, the renderer only re-sorts after one
+		renderRequests.track_changes();
+		// Levels adding or removing terrain trigger a rebake of the static collision grid
+		terrain.track_changes();
+		// Bodies falling asleep or waking up trigger a rebake of the sleeping collision grid
+		sleeping.track_changes();
 	}
 
+	// For use while iterating the collisions, they are cleared as a whole afterwards
 	void remove_all_components_of_no_collision(Entity e) {
-		for (ContainerInterface* reg : registry_list) {
-			if (reg == &collisions) continue;
-			reg->remove(e);
-		}
+		remove_all_components_of<Collision>(e);
 	}
 };
 
-extern ECSRegistry registry;
\ No newline at end of file
+extern ECSRegistry registry;
@@ -15,6 +15,7 @@ void UISystem::showWindows() {
 	if (state == MAIN_MENU) showMainMenu(&show_menu);
 	if (state == PAUSE_MENU) showPauseMenu(&show_menu);
 	if (show_tutorial) showTutorial(&show_tutorial);
+	if (debugging.show_ai_lod && state == PLAY_GAME) showAILod(&debugging.show_ai_lod);
 }
 
 void UISystem::showMainMenu(bool* p_open) {
@@ -183,6 +184,39 @@ void UISystem::showTutorial(bool* p_open) {
 	ImGui::End();
 }
 
+// Debug overlay: every enemy labelled with its AI LOD tier, and the number of enemies per tier
+void UISystem::showAILod(bool* p_open) {
+	static ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoInputs;
+	const ImVec4 tier_colors[] = { ImVec4(0.3f, 1.f, 0.3f, 1.f), ImVec4(1.f, 0.85f, 0.2f, 1.f), ImVec4(1.f, 0.3f, 0.3f, 1.f) };
+
+	const ImGuiViewport* viewport = ImGui::GetMainViewport();
+	ImGui::SetNextWindowPos(viewport->Pos);
+	ImGui::SetNextWindowSize(viewport->Size);
+
+	if (ImGui::Begin("AI LOD", p_open, flags)) {
+		int counts[3] = { 0, 0, 0 };
+		for (uint i = 0; i < registry.aiLods.size(); i++) {
+			Entity entity = registry.aiLods.entities[i];
+			int tier = registry.aiLods.components[i].tier;
+			if (!registry.positions.has(entity) || tier < 0 || tier > 2) continue;
+			counts[tier]++;
+
+			PositionRef position = registry.positions.get(entity);
+			std::string label = "LOD " + std::to_string(tier);
+			ImGui::PushStyleColor(ImGuiCol_Text, tier_colors[tier]);
+			WorldCoordinateText(label.c_str(), position.position.x - ImGui::CalcTextSize(label.c_str()).x / 2, position.position.y - abs(position.scale.y) / 2 - 20.f);
+			ImGui::PopStyleColor();
+		}
+
+		std::string summary = "AI LOD  0: " + std::to_string(counts[0]) + "  1: " + std::to_string(counts[1]) + "  2: " + std::to_string(counts[2]);
+		ImGui::SetCursorPos(ImVec2(10.f, 10.f));
+		ImGui::Text("%s", summary.c_str());
+		ImGui::Text("AI step %.2f ms, %zu updates deferred", debugging.ai_step_ms, debugging.ai_deferred_updates);
+	}
+
+	ImGui::End();
+}
+
 void UISystem::CenterText(const char* text) {
 	ImVec2 textSize = ImGui::CalcTextSize(text);
 	float w = ImGui::GetWindowWidth();
@@ -48,6 +48,7 @@ private:
 	void showMainMenu(bool* p_open);
 	void showPauseMenu(bool* p_open);
 	void showTutorial(bool* p_open);
+	void showAILod(bool* p_open);
 	void CenterText(const char* text);
 	void WorldCoordinateText(const char* text, float x, float y);
 
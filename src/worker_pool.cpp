@@ -0,0 +1,76 @@
+// internal
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned int threads)
+{
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int i = 1; i < threads; i++)
+		workers.emplace_back(&WorkerPool::workerLoop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	work_ready.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void WorkerPool::run(unsigned int chunks, const std::function<void(unsigned int)>& task)
+{
+	if (chunks == 0)
+		return;
+	if (workers.empty() || chunks == 1) {
+		for (unsigned int chunk = 0; chunk < chunks; chunk++)
+			task(chunk);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->task = &task;
+		this->chunks = chunks;
+		next_chunk = 0;
+		busy = (unsigned int)workers.size();
+		generation++;
+	}
+	work_ready.notify_all();
+	work();
+
+	// Every worker takes part in every run, so the task stays valid until all of them checked out
+	std::unique_lock<std::mutex> lock(mutex);
+	work_done.wait(lock, [this] { return busy == 0; });
+	this->task = nullptr;
+}
+
+void WorkerPool::work()
+{
+	for (unsigned int chunk = next_chunk++; chunk < chunks; chunk = next_chunk++)
+		(*task)(chunk);
+}
+
+void WorkerPool::workerLoop()
+{
+	unsigned long long seen = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			work_ready.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+		}
+		work();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busy == 0)
+				work_done.notify_one();
+		}
+	}
+}
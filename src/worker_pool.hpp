@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads running the chunks of one task at a time. The calling thread works on the
+// chunks too, so a pool of 1 thread runs everything inline.
+class WorkerPool
+{
+public:
+	// threads counts the caller, 0 uses one per hardware thread
+	explicit WorkerPool(unsigned int threads = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	unsigned int size() const { return (unsigned int)workers.size() + 1; }
+
+	// Calls task(chunk) for every chunk in [0, chunks) across the pool and returns once all are done.
+	// Chunks are handed out in increasing order but may finish in any order.
+	void run(unsigned int chunks, const std::function<void(unsigned int)>& task);
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+
+	// The task being run, published under the mutex by bumping generation
+	const std::function<void(unsigned int)>* task = nullptr;
+	unsigned int chunks = 0;
+	std::atomic<unsigned int> next_chunk{ 0 };
+	unsigned int busy = 0;
+	unsigned long long generation = 0;
+	bool stopping = false;
+
+	void work();
+	void workerLoop();
+};
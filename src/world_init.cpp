@@ -4,7 +4,7 @@
 
 Entity createAria(RenderSystem* renderer, vec2 pos)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::PLAYER);
@@ -15,7 +15,10 @@ Entity createAria(RenderSystem* renderer, vec2 pos)
 
 	registry.characterProjectileTypes.emplace(entity);
 	registry.players.emplace(entity);
-	registry.collidables.emplace(entity);
+	Collidable& collidable = registry.collidables.emplace(entity);
+	collidable.category = CATEGORY_PLAYER;
+	collidable.mask = CATEGORY_ENEMY | CATEGORY_BOSS | CATEGORY_TERRAIN | CATEGORY_OBSTACLE | CATEGORY_ENEMY_PROJECTILE |
+		CATEGORY_EXIT_DOOR | CATEGORY_PICKUP | CATEGORY_LOST_SOUL;
 
 	Animation& animation = registry.animations.emplace(entity);
 	animation.sprite_sheet_ptr = &sprite_sheet;
@@ -23,7 +26,7 @@ Entity createAria(RenderSystem* renderer, vec2 pos)
 	animation.is_animating = false; // initially stationary
 
 	// set initial component values
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = pos;
 	position.scale = vec2(63.f, 100.f);
 
@@ -57,17 +60,18 @@ Entity createAria(RenderSystem* renderer, vec2 pos)
 		entity,
 		{ TEXTURE_ASSET_ID::PLAYER,
 			EFFECT_ASSET_ID::ANIMATED,
-			GEOMETRY_BUFFER_ID::PLAYER});
+			GEOMETRY_BUFFER_ID::PLAYER,
+			RENDER_LAYER::PLAYER});
 
 	return entity;
 }
 
 Entity createFloor(RenderSystem* renderer, vec2 pos, vec2 size)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// set initial component values
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.scale = size;
 	// pos passed in to createFloor assumes top left corner is (x,y)
 	position.position = vec2(pos.x + position.scale.x/2, pos.y + position.scale.y/2);
@@ -78,14 +82,15 @@ Entity createFloor(RenderSystem* renderer, vec2 pos, vec2 size)
 		entity,
 		{ TEXTURE_ASSET_ID::FLOOR,
 			EFFECT_ASSET_ID::REPEAT,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::FLOOR });
 
 	return entity;
 }
 
 Entity createTerrain(RenderSystem* renderer, vec2 pos, vec2 size, DIRECTION dir, float speed, bool moveable)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
@@ -95,7 +100,7 @@ Entity createTerrain(RenderSystem* renderer, vec2 pos, vec2 size, DIRECTION dir,
 
 	// The position passed into createTerrain (x,y) assumes the top left corner
 	// and size corresponds to width and height
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = vec2(pos.x + size.x/2, pos.y + size.y/2);
 	position.prev_position = vec2(pos.x + size.x / 2, pos.y + size.y / 2);
 	position.scale = size;
@@ -113,17 +118,21 @@ Entity createTerrain(RenderSystem* renderer, vec2 pos, vec2 size, DIRECTION dir,
 		(dir == DIRECTION::E ?  TEXTURE_ASSET_ID::SIDE_TERRAIN : 
 			                    TEXTURE_ASSET_ID::GENERIC_TERRAIN));
 
-	registry.collidables.emplace(entity); // Marking terrain as collidable
+	Collidable& collidable = registry.collidables.emplace(entity); // Marking terrain as collidable
+	collidable.category = CATEGORY_TERRAIN;
+	collidable.mask = CATEGORY_PLAYER | CATEGORY_ENEMY | CATEGORY_BOSS | CATEGORY_TERRAIN | CATEGORY_OBSTACLE |
+		CATEGORY_PLAYER_PROJECTILE | CATEGORY_ENEMY_PROJECTILE;
 	registry.renderRequests.insert(
 		entity,
 		{ tex,
 			EFFECT_ASSET_ID::REPEAT,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::TERRAIN });
 	
 	return entity;
 }
 Entity createObstacle(RenderSystem* renderer, vec2 pos, vec2 size, vec2 vel) {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::GHOST_SHEET);
 	registry.meshPtrs.emplace(entity, &mesh);
@@ -134,7 +143,7 @@ Entity createObstacle(RenderSystem* renderer, vec2 pos, vec2 size, vec2 vel) {
 	Animation& animation = registry.animations.emplace(entity);
 	animation.sprite_sheet_ptr = &sprite_sheet;
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = pos;
 
 	float scale_factor = size.y / sprite_sheet.frame_height;
@@ -144,7 +153,9 @@ Entity createObstacle(RenderSystem* renderer, vec2 pos, vec2 size, vec2 vel) {
 	velocity.velocity = vel;
 
 	Obstacle& obstacle = registry.obstacles.emplace(entity);
-	registry.collidables.emplace(entity); // Marking obstacle as collidable
+	Collidable& collidable = registry.collidables.emplace(entity); // Marking obstacle as collidable
+	collidable.category = CATEGORY_OBSTACLE;
+	collidable.mask = CATEGORY_PLAYER | CATEGORY_TERRAIN | CATEGORY_OBSTACLE;
 
 	createShadow(renderer, entity, TEXTURE_ASSET_ID::GHOST, GEOMETRY_BUFFER_ID::SPRITE);
 
@@ -152,13 +163,14 @@ Entity createObstacle(RenderSystem* renderer, vec2 pos, vec2 size, vec2 vel) {
 		entity,
 		{ TEXTURE_ASSET_ID::GHOST_SHEET,
 			EFFECT_ASSET_ID::ANIMATED,
-			GEOMETRY_BUFFER_ID::GHOST_SHEET });
+			GEOMETRY_BUFFER_ID::GHOST_SHEET,
+			RENDER_LAYER::ENEMY });
 
 	return entity;
 }
 
 Entity createLostSoul(RenderSystem* renderer, vec2 pos) {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	registry.lostSouls.emplace(entity);
 
@@ -173,7 +185,7 @@ Entity createLostSoul(RenderSystem* renderer, vec2 pos) {
 	animation.setState((int)LOST_SOUL_STATES::EAST_IDLE);
 	animation.is_animating = true;
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = pos;
 
 	Velocity& velocity = registry.velocities.emplace(entity);
@@ -181,7 +193,9 @@ Entity createLostSoul(RenderSystem* renderer, vec2 pos) {
 
 	position.scale = vec2(100, 100);
 
-	registry.collidables.emplace(entity); // Marking obstacle as collidable
+	Collidable& collidable = registry.collidables.emplace(entity); // Marking lost soul as collidable
+	collidable.category = CATEGORY_LOST_SOUL;
+	collidable.mask = CATEGORY_PLAYER;
 
 	createShadow(renderer, entity, TEXTURE_ASSET_ID::LOST_SOUL, GEOMETRY_BUFFER_ID::SPRITE);
 
@@ -192,7 +206,8 @@ Entity createLostSoul(RenderSystem* renderer, vec2 pos) {
 		entity,
 		{ TEXTURE_ASSET_ID::LOST_SOUL_SHEET,
 			EFFECT_ASSET_ID::ANIMATED,
-			GEOMETRY_BUFFER_ID::LOST_SOUL });
+			GEOMETRY_BUFFER_ID::LOST_SOUL,
+			RENDER_LAYER::ENEMY });
 
 	return entity;
 }
@@ -200,9 +215,9 @@ Entity createLostSoul(RenderSystem* renderer, vec2 pos) {
 
 Entity createEnemy(RenderSystem* renderer, vec2 pos, Enemy enemyAttributes)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = pos;
 
 	Velocity& velocity = registry.velocities.emplace(entity);
@@ -268,23 +283,26 @@ Entity createEnemy(RenderSystem* renderer, vec2 pos, Enemy enemyAttributes)
 
 	createShadow(renderer, entity, shadow_texture_asset, GEOMETRY_BUFFER_ID::SPRITE);
 
-	registry.collidables.emplace(entity);
+	Collidable& collidable = registry.collidables.emplace(entity);
+	collidable.category = CATEGORY_ENEMY;
+	collidable.mask = CATEGORY_PLAYER | CATEGORY_TERRAIN | CATEGORY_PLAYER_PROJECTILE | CATEGORY_ENEMY_PROJECTILE;
 	registry.renderRequests.insert(
 		entity,
 		{texture_asset,
 		 EFFECT_ASSET_ID::ANIMATED,
-		 geom_buffer });
+		 geom_buffer,
+		 RENDER_LAYER::ENEMY });
 
 	return entity;
 }
 
 Entity createBoss(RenderSystem* renderer, vec2 pos, Enemy enemyAttributes)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	Boss& boss = registry.bosses.emplace(entity);
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = pos;
 
 	position.scale = vec2({ 230, 200 });
@@ -381,19 +399,22 @@ Entity createBoss(RenderSystem* renderer, vec2 pos, Enemy enemyAttributes)
 	
 	createShadow(renderer, entity, shadowTextureAsset, GEOMETRY_BUFFER_ID::SPRITE);
 
-	registry.collidables.emplace(entity);
+	Collidable& collidable = registry.collidables.emplace(entity);
+	collidable.category = CATEGORY_BOSS;
+	collidable.mask = CATEGORY_PLAYER | CATEGORY_TERRAIN | CATEGORY_PLAYER_PROJECTILE;
 	registry.renderRequests.insert(
 		entity,
 		{ textureAsset,
 		 effectAsset,
-		 geomBuffer });
+		 geomBuffer,
+		 RENDER_LAYER::ENEMY });
 
 	return entity;
 }
 
 Entity createFinalBossAura(RenderSystem* renderer, Entity& owner_entity, float x_offset, float y_offset)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::FINAL_BOSS_AURA);
 	registry.meshPtrs.emplace(entity, &mesh);
@@ -405,34 +426,33 @@ Entity createFinalBossAura(RenderSystem* renderer, Entity& owner_entity, float x
 	animation.setState((int)FINAL_BOSS_AURA_SPRITE_STATES::NONE);
 	animation.is_animating = false;
 	
-	Follower& follower = registry.followers.emplace(entity);
-	follower.owner = owner_entity;
-	follower.y_offset = y_offset;
-	follower.x_offset = x_offset;
+	Parent& parent = registry.parents.emplace(entity);
+	parent.entity = owner_entity;
+	parent.offset = vec2(x_offset, y_offset);
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.scale = vec2(2.f * sprite_sheet.frame_width, 2.f * sprite_sheet.frame_height);
 
 	registry.renderRequests.insert(
 		entity,
 		{ TEXTURE_ASSET_ID::FINAL_BOSS_AURA,
 		 EFFECT_ASSET_ID::ANIMATED,
-		 GEOMETRY_BUFFER_ID::FINAL_BOSS_AURA });
+		 GEOMETRY_BUFFER_ID::FINAL_BOSS_AURA,
+		 RENDER_LAYER::AURA });
 
 	return entity;
 }
 
 Entity createHealthBar(RenderSystem* renderer, Entity& resource_entity, Entity& position_entity, float x_offset, float y_offset)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	HealthBar& healthBar = registry.healthBars.emplace(entity);
 	healthBar.owner = resource_entity;
 
-	Follower& follower = registry.followers.emplace(entity);
-	follower.owner = position_entity;
-	follower.y_offset = y_offset;
-	follower.x_offset = x_offset;
+	Parent& parent = registry.parents.emplace(entity);
+	parent.entity = position_entity;
+	parent.offset = vec2(x_offset, y_offset);
 
 	float width;
 	float height;
@@ -462,29 +482,29 @@ Entity createHealthBar(RenderSystem* renderer, Entity& resource_entity, Entity&
 	resources.barRatio = (width - height) / width;
 	resources.logoRatio = height / width;
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.scale = vec2(scale_factor * width, scale_factor * height);
 
 	registry.renderRequests.insert(
 		entity,
 		{ texture_asset,
 			EFFECT_ASSET_ID::RESOURCE_BAR,
-			GEOMETRY_BUFFER_ID::RESOURCE_BAR });
+			GEOMETRY_BUFFER_ID::RESOURCE_BAR,
+			RENDER_LAYER::UI });
 
 	return entity;
 }
 
 Entity createManaBar(RenderSystem* renderer, Entity& resource_entity, Entity& position_entity, float x_offset, float y_offset)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	ManaBar& manaBar = registry.manaBars.emplace(entity);
 	manaBar.owner = resource_entity;
 
-	Follower& follower = registry.followers.emplace(entity);
-	follower.owner = position_entity;
-	follower.y_offset = y_offset;
-	follower.x_offset = x_offset;
+	Parent& parent = registry.parents.emplace(entity);
+	parent.entity = position_entity;
+	parent.offset = vec2(x_offset, y_offset);
 
 	float width;
 	float height;
@@ -508,39 +528,43 @@ Entity createManaBar(RenderSystem* renderer, Entity& resource_entity, Entity& po
 	resources.barRatio = (width - height) / width;
 	resources.logoRatio = height / width;
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.scale = vec2(scale_factor * width, scale_factor * height);
 
 	registry.renderRequests.insert(
 		entity,
 		{ texture_asset,
 			EFFECT_ASSET_ID::RESOURCE_BAR,
-			GEOMETRY_BUFFER_ID::RESOURCE_BAR });
+			GEOMETRY_BUFFER_ID::RESOURCE_BAR,
+			RENDER_LAYER::UI });
 
 	return entity;
 }
 
 Entity createHealthPack(RenderSystem* renderer, vec2 pos)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	HealthPack& health_pack = registry.healthPacks.emplace(entity);
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Position& health_pack_position = registry.positions.emplace(entity);
+	PositionRef health_pack_position = registry.positions.emplace(entity);
 	health_pack_position.position = pos;
 	health_pack_position.scale = vec2(75.f, 75.f);
 
-	registry.collidables.emplace(entity);
+	Collidable& collidable = registry.collidables.emplace(entity);
+	collidable.category = CATEGORY_PICKUP;
+	collidable.mask = CATEGORY_PLAYER;
 
 	registry.renderRequests.insert(
 		entity,
 		{
 			TEXTURE_ASSET_ID::HEALTH_PACK,
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::ITEM
 		}
 	);
 
@@ -549,7 +573,7 @@ Entity createHealthPack(RenderSystem* renderer, vec2 pos)
 
 Entity createShadow(RenderSystem* renderer, Entity& owner_entity, TEXTURE_ASSET_ID texture, GEOMETRY_BUFFER_ID geom)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	Shadow& shadow = registry.shadows.emplace(entity);
 	shadow.owner = owner_entity;
@@ -558,8 +582,9 @@ Entity createShadow(RenderSystem* renderer, Entity& owner_entity, TEXTURE_ASSET_
 	Mesh& mesh = renderer->getMesh(geom);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Position& owner_position = registry.positions.get(owner_entity);
-	Position& position = registry.positions.emplace(entity);
+	// A copy, the emplace below may move the position arrays
+	Position owner_position = registry.positions.get(owner_entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = owner_position.position;
 	position.scale = owner_position.scale;
 	shadow.original_size = position.scale;
@@ -568,14 +593,15 @@ Entity createShadow(RenderSystem* renderer, Entity& owner_entity, TEXTURE_ASSET_
 		entity,
 		{ texture,
 			EFFECT_ASSET_ID::SHADOW,
-			geom });
+			geom,
+			RENDER_LAYER::SHADOW });
 
 	return entity;
 }
 
 Entity createProjectileSelectDisplay(RenderSystem* renderer, Entity& owner_entity, float x_offset, float y_offset)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	SpriteSheet& sprite_sheet = renderer->getSpriteSheet(SPRITE_SHEET_DATA_ID::PROJECTILE_SELECT_DISPLAY);
 	registry.spriteSheetPtrs.emplace(entity, &sprite_sheet);
@@ -586,14 +612,13 @@ Entity createProjectileSelectDisplay(RenderSystem* renderer, Entity& owner_entit
 	animation.setState((int) characterProjectileType.projectileType);
 	animation.is_animating = false;
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	float scale_factor = 2.f;
 	position.scale = vec2(scale_factor * sprite_sheet.frame_width, scale_factor * sprite_sheet.frame_height);
 
-	Follower& follower = registry.followers.emplace(entity);
-	follower.owner = owner_entity;
-	follower.y_offset = y_offset;
-	follower.x_offset = x_offset;
+	Parent& parent = registry.parents.emplace(entity);
+	parent.entity = owner_entity;
+	parent.offset = vec2(x_offset, y_offset);
 
 
 	ProjectileSelectDisplay& display = registry.projectileSelectDisplays.emplace(entity);
@@ -608,40 +633,41 @@ Entity createProjectileSelectDisplay(RenderSystem* renderer, Entity& owner_entit
 		entity,
 		{ TEXTURE_ASSET_ID::PROJECTILE_SELECT_DISPLAY,
 			EFFECT_ASSET_ID::ANIMATED,
-			GEOMETRY_BUFFER_ID::PROJECTILE_SELECT_DISPLAY });
+			GEOMETRY_BUFFER_ID::PROJECTILE_SELECT_DISPLAY,
+			RENDER_LAYER::UI });
 
 	return entity;
 }
 
 Entity createPowerUpIndicator(RenderSystem* renderer, Entity& owner_entity, vec2 size, TEXTURE_ASSET_ID texture, float x_offset, float y_offset)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	registry.powerUpIndicators.emplace(entity);
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	float scale_factor = 2.f;
 	position.scale = vec2(scale_factor * size.x, scale_factor * size.y);
 
-	SecondaryFollower& follower = registry.secondaryFollowers.emplace(entity);
-	follower.owner = owner_entity;
-	follower.y_offset = y_offset;
-	follower.x_offset = x_offset;
+	Parent& parent = registry.parents.emplace(entity);
+	parent.entity = owner_entity;
+	parent.offset = vec2(x_offset, y_offset);
 
 	registry.renderRequests.insert(
 		entity,
 		{ texture,
 			EFFECT_ASSET_ID::TEXTURED,
-			GEOMETRY_BUFFER_ID::SPRITE });
+			GEOMETRY_BUFFER_ID::SPRITE,
+			RENDER_LAYER::UI });
 
 	return entity;
 }
 
 Entity createExitDoor(RenderSystem* renderer, vec2 pos) {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
@@ -654,23 +680,26 @@ Entity createExitDoor(RenderSystem* renderer, vec2 pos) {
 	animation.setState((int)PORTAL_STATES::OPEN);
 	animation.is_animating = true;
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.scale = vec2(100.f, 120.f);
 	position.position = vec2(pos.x + position.scale.x/2, pos.y + position.scale.y/2);
 
 	registry.exitDoors.emplace(entity);
-	registry.collidables.emplace(entity);
+	Collidable& collidable = registry.collidables.emplace(entity);
+	collidable.category = CATEGORY_EXIT_DOOR;
+	collidable.mask = CATEGORY_PLAYER;
 	registry.renderRequests.insert(
 		entity,
 		{ TEXTURE_ASSET_ID::PORTAL,
 			EFFECT_ASSET_ID::ANIMATED,
-			GEOMETRY_BUFFER_ID::PORTAL});
+			GEOMETRY_BUFFER_ID::PORTAL,
+			RENDER_LAYER::ITEM});
 
 	return entity;
 }
 
 Entity createPowerUpBlock(RenderSystem* renderer, pair<string, bool*>* powerUp, vec2 pos) {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
@@ -683,7 +712,7 @@ Entity createPowerUpBlock(RenderSystem* renderer, pair<string, bool*>* powerUp,
 	animation.setState((int)POWER_UP_BLOCK_STATES::ACTIVE);
 	animation.rainbow_enabled = true;
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = pos;
 	position.scale = vec2(90.f, 90.f);
 
@@ -691,26 +720,29 @@ Entity createPowerUpBlock(RenderSystem* renderer, pair<string, bool*>* powerUp,
 	powerUpBlock.powerUpText = powerUp->first;
 	powerUpBlock.powerUpToggle = powerUp->second;
 
-	registry.collidables.emplace(entity);
+	Collidable& collidable = registry.collidables.emplace(entity);
+	collidable.category = CATEGORY_POWER_UP_BLOCK;
+	collidable.mask = CATEGORY_PLAYER_PROJECTILE | CATEGORY_ENEMY_PROJECTILE;
 	registry.renderRequests.insert(
 		entity,
 		{ TEXTURE_ASSET_ID::POWER_UP_BLOCK,
 			EFFECT_ASSET_ID::ANIMATED,
-			GEOMETRY_BUFFER_ID::POWER_UP_BLOCK });
+			GEOMETRY_BUFFER_ID::POWER_UP_BLOCK,
+			RENDER_LAYER::ITEM });
 
 	return entity;
 }
 
 Entity createTestSalmon(RenderSystem* renderer, vec2 pos)
 {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SALMON);
 	registry.meshPtrs.emplace(entity, &mesh);
 
 	// set initial component values
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = pos;
 	position.scale = mesh.original_size * 150.f;
 	position.scale.x *= -1; // point front to the right; with sprites this wont be a thing?
@@ -726,18 +758,22 @@ Entity createTestSalmon(RenderSystem* renderer, vec2 pos)
 	direction.direction = DIRECTION::E;
 
 	registry.players.emplace(entity);
-	registry.collidables.emplace(entity);
+	Collidable& collidable = registry.collidables.emplace(entity);
+	collidable.category = CATEGORY_PLAYER;
+	collidable.mask = CATEGORY_ENEMY | CATEGORY_BOSS | CATEGORY_TERRAIN | CATEGORY_OBSTACLE | CATEGORY_ENEMY_PROJECTILE |
+		CATEGORY_EXIT_DOOR | CATEGORY_PICKUP | CATEGORY_LOST_SOUL;
 	registry.renderRequests.insert(
 		entity,
 		{ TEXTURE_ASSET_ID::TEXTURE_COUNT, // TEXTURE_COUNT indicates that no txture is needed
 			EFFECT_ASSET_ID::SALMON,
-			GEOMETRY_BUFFER_ID::SALMON });
+			GEOMETRY_BUFFER_ID::SALMON,
+			RENDER_LAYER::ENEMY });
 
 	return entity;
 }
 
 Entity createProjectile(RenderSystem* renderer, vec2 pos, vec2 vel, ElementType elementType, bool hostile, Entity& player) {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	Projectile& projectile = registry.projectiles.emplace(entity);
 	projectile.type = elementType;
@@ -789,12 +825,17 @@ Entity createProjectile(RenderSystem* renderer, vec2 pos, vec2 vel, ElementType
 	velocity.velocity = vel;
 
 	// Set initial position and velocity for the projectile
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = pos;
 	position.angle = atan2(vel.y, vel.x);
 	position.scale = vec2(sprite_sheet.frame_width, sprite_sheet.frame_height);
 
-	registry.collidables.emplace(entity);
+	Collidable& collidable = registry.collidables.emplace(entity);
+	// Hostile projectiles heal enemies of other types, boss projectiles pass through the boss
+	collidable.category = hostile ? CATEGORY_ENEMY_PROJECTILE : CATEGORY_PLAYER_PROJECTILE;
+	collidable.mask = (hostile ? CATEGORY_PLAYER | CATEGORY_ENEMY : CATEGORY_ENEMY | CATEGORY_BOSS) |
+		CATEGORY_TERRAIN | CATEGORY_POWER_UP_BLOCK;
+	collidable.continuous = true;
   if (!hostile) {
 	  PowerUp& powerUp = registry.powerUps.get(player);
 	  if (powerUp.tripleShot[elementType]) projectile.damage *= 0.5f; // triple shot projectiles are decreased damage
@@ -806,15 +847,16 @@ Entity createProjectile(RenderSystem* renderer, vec2 pos, vec2 vel, ElementType
 		entity,
 		{	textureAsset,
 			EFFECT_ASSET_ID::ANIMATED,
-			geometryBuffer });
+			geometryBuffer,
+			RENDER_LAYER::PROJECTILE });
 	return entity;
 }
 
 Entity createText(std::string in_text, vec2 pos, float scale, vec3 color)
 {
-	Entity entity = Entity();
+	Entity entity = Entity::create();
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = pos;
 	position.scale = vec2(scale, scale);
 
@@ -826,21 +868,23 @@ Entity createText(std::string in_text, vec2 pos, float scale, vec3 color)
 		entity,
 		{ TEXTURE_ASSET_ID::TEXTURE_COUNT,
 			EFFECT_ASSET_ID::TEXT_2D,
-			GEOMETRY_BUFFER_ID::TEXT_2D });
+			GEOMETRY_BUFFER_ID::TEXT_2D,
+			RENDER_LAYER::UI });
 
 	return entity;
 }
 
 Entity createLine(vec2 position, vec2 scale)
 {
-	Entity entity = Entity();
+	Entity entity = Entity::create();
 
 	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
 	registry.renderRequests.insert(
 		entity,
 		{ TEXTURE_ASSET_ID::TEXTURE_COUNT,
 		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::DEBUG_LINE });
+		 GEOMETRY_BUFFER_ID::DEBUG_LINE,
+		 RENDER_LAYER::UI });
 
 	// Create motion
 	/*
@@ -856,17 +900,19 @@ Entity createLine(vec2 position, vec2 scale)
 }
 
 Entity createLifeOrb(RenderSystem* renderer, vec2 pos, int piece_number) {
-	auto entity = Entity();
+	auto entity = Entity::create();
 
 	LifeOrb& life_orb = registry.lifeOrbs.emplace(entity);
 
-	Position& position = registry.positions.emplace(entity);
+	PositionRef position = registry.positions.emplace(entity);
 	position.position = pos;
 	
 	Velocity& velocity = registry.velocities.emplace(entity);
 	velocity.velocity = { 0.f,0.f };
 
-	registry.collidables.emplace(entity);
+	Collidable& collidable = registry.collidables.emplace(entity);
+	collidable.category = CATEGORY_PICKUP;
+	collidable.mask = CATEGORY_PLAYER;
 
 	SPRITE_SHEET_DATA_ID ss_id = SPRITE_SHEET_DATA_ID::LIFE_ORB;
 	TEXTURE_ASSET_ID asset = TEXTURE_ASSET_ID::LIFE_ORB;
@@ -893,7 +939,8 @@ Entity createLifeOrb(RenderSystem* renderer, vec2 pos, int piece_number) {
 		entity,
 		{ asset,
 			EFFECT_ASSET_ID::ANIMATED,
-			geom_buffer });
+			geom_buffer,
+			RENDER_LAYER::ITEM });
 
 	return entity;
 }
\ No newline at end of file
@@ -304,18 +304,18 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		InvulnerableTimer& timer = registry.invulnerableTimers.get(entity);
 		timer.timer_ms -= elapsed_ms_since_last_update;
 		if (timer.timer_ms <= 0) {
-			registry.invulnerableTimers.remove(entity);
+			registry.commands.remove(registry.invulnerableTimers, entity);
 		}
 	}
 
 	Resources& player_resource = registry.resources.get(player);
 	if (player_resource.currentMana < 10.f) {
 		// replenish mana
-		player_resource.currentMana += elapsed_ms_since_last_update / 1000;
+		player_resource.currentMana += elapsed_ms_since_last_update / 500;
 		if (player_resource.currentMana > 10.f) player_resource.currentMana = 10.f;
 	}
 
-    float min_death_timer_ms = 2700.f;
+    float min_death_timer_ms = 1350.f;
 	for (Entity entity : registry.deathTimers.entities) {
 		DeathTimer& timer = registry.deathTimers.get(entity);
 		timer.timer_ms -= elapsed_ms_since_last_update;
@@ -330,9 +330,9 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			return true;
 		}
 	}
-	screen.screen_darken_factor = 1 - min_death_timer_ms / 2700;
+	screen.screen_darken_factor = 1 - min_death_timer_ms / 1350;
 
-	float min_win_timer_ms = 3600.f;
+	float min_win_timer_ms = 1800.f;
 	for (Entity entity : registry.winTimers.entities) {
 		WinTimer& timer = registry.winTimers.get(entity);
 		timer.timer_ms = std::min(timer.timer_ms, min_win_timer_ms);
@@ -343,7 +343,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		}
 		if (timer.timer_ms <= 0.f) {
 			screen.apply_spotlight = true;
-			screen.spotlight_radius = -timer.timer_ms / 400.f;
+			screen.spotlight_radius = -timer.timer_ms / 200.f;
 
 			// Change level here
 			if (!timer.changedLevel) {
@@ -364,8 +364,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 				restart_game();
 			}
 		}
-		if (timer.timer_ms <= -4000.f) {
-			registry.winTimers.remove(entity);
+		if (timer.timer_ms <= -2000.f) {
+			registry.commands.remove(registry.winTimers, entity);
 			screen.apply_spotlight = false;
 		}
 	}
@@ -375,7 +375,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		timer.timer_ms -= elapsed_ms_since_last_update;
 		if (timer.timer_ms <= 0.f) {
 			// Weakness to this element has expired
-			float max_timer = 12000.f;
+			float max_timer = 6000.f;
 			float curr_timer = max_timer * uniform_dist(rng);
 
 			ElementType elementType = getRandomElementType();
@@ -428,7 +428,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	if (this->curr_level.curr_level == CUTSCENE_2) {
 		//First turn downwards
 		float initial_speed = this->curr_level.cutscene_player_velocity.x;
-		Position& player_position = registry.positions.get(player);
+		PositionRef player_position = registry.positions.patch(player);
 		Entity& lost_soul = registry.lostSouls.entities[0];
 		vec2 player_pos = registry.positions.get(player).position;
 		vec2 lost_soul_pos = registry.positions.get(lost_soul).position;
@@ -495,7 +495,6 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		Entity& timer = registry.obstacles.entities[0];
 		float timer_x_pos = registry.positions.get(timer).position.x;
 		Entity& life_orb = registry.lifeOrbs.entities[0];
-		Position& player_position = registry.positions.get(player);
 
 		//Velocity
 		Velocity& player_vel = registry.velocities.get(player);
@@ -518,7 +517,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			registry.remove_all_components_of(registry.lifeOrbs.entities[0]);
 
 			Entity orb = createLifeOrb(renderer, vec2(1050.f, 150.f), 0); // light source should be behind boss so it looks like boss is glowing
-			registry.positions.get(orb).scale = { 0, 0 };
+			registry.positions.patch(orb).scale = { 0, 0 };
+			registry.renderRequests.patch(orb).layer = RENDER_LAYER::AURA;
 			Entity final_boss = createBoss(renderer, vec2(1050.f, 200.f), FINAL_BOSS_ATTRS);
 			// set direction of boss to left
 		}
@@ -563,7 +563,6 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 		Entity& timer = registry.obstacles.entities[0];
 		float timer_x_pos = registry.positions.get(timer).position.x;
 		Entity& life_orb = registry.lifeOrbs.entities[0];
-		Position& player_position = registry.positions.get(player);
 		
 		//Velocity
 		Velocity& player_vel = registry.velocities.get(player);
@@ -636,6 +635,14 @@ void WorldSystem::restart_game() {
 	std::vector<std::pair<vec2, LostSoul>> lost_soul_attrs = current_level.getLostSouls();
 	std::vector<std::array<vec2, OBSTACLE_ATTRIBUTES >> obstacles = current_level.getObstacleAttrs();
 
+	// Size the containers for the level's peak, the containers never shrink so this only allocates
+	// when the level is bigger than anything seen before
+	size_t entity_budget = current_level.getEntityBudget();
+	size_t projectile_budget = current_level.getProjectileBudget();
+	registry.reserve<Position, Velocity, Collidable, Animation, RenderRequest, Mesh*, SpriteSheet*>(entity_budget);
+	registry.reserve<Projectile>(projectile_budget);
+	registry.reserve<Collision>(4 * projectile_budget);
+
 	if (this->curr_level.getIsBossLevel()) {
 		Mix_FadeInMusic(boss_intro_music, 0, 500);
 
@@ -769,7 +776,7 @@ void WorldSystem::restart_game() {
 		registry.lifeOrbs.get(life_orb).centered_on_screen = true;
 		registry.velocities.get(life_orb).velocity = { 0.f,20.f };
 		registry.velocities.get(player).velocity = this->curr_level.cutscene_player_velocity;
-		Position& player_position = registry.positions.get(player);
+		PositionRef player_position = registry.positions.patch(player);
 		if (player_position.scale.x > 0) player_position.scale.x *= -1;
 	}
 	else if (this->curr_level.getCurrLevel() == CUTSCENE_5) {
@@ -806,32 +813,32 @@ void WorldSystem::restart_game() {
 
 // These collision checks check if previously they weren't overlapping from a certain direction
 // then they started to overlap after having stepped from the physics system
-bool collidedLeft(Position& pos_i, Position& pos_j) 
+bool collidedLeft(PositionRef pos_i, PositionRef pos_j) 
 {
 	return (((pos_i.prev_position.x + abs(pos_i.scale.x / 2)) <= (pos_j.prev_position.x - abs(pos_j.scale.x / 2))) &&
 		((pos_i.position.x + abs(pos_i.scale.x / 2)) >= (pos_j.position.x - abs(pos_j.scale.x/2))));
 }
 
-bool collidedRight(Position& pos_i, Position& pos_j) 
+bool collidedRight(PositionRef pos_i, PositionRef pos_j) 
 {
 	return (((pos_i.prev_position.x - abs(pos_i.scale.x / 2)) >= (pos_j.prev_position.x + abs(pos_j.scale.x / 2))) &&
 		((pos_i.position.x - abs(pos_i.scale.x / 2)) <= (pos_j.position.x + abs(pos_j.scale.x/2))));
 }
 
-bool collidedTop(Position& pos_i, Position& pos_j) 
+bool collidedTop(PositionRef pos_i, PositionRef pos_j) 
 {
 	return (((pos_i.prev_position.y + abs(pos_i.scale.y / 2)) <= (pos_j.prev_position.y - abs(pos_j.scale.y / 2))) &&
 		((pos_i.position.y + abs(pos_i.scale.y / 2)) >= (pos_j.position.y - abs(pos_j.scale.y/2))));
 }
 
-bool collidedBottom(Position& pos_i, Position& pos_j) 
+bool collidedBottom(PositionRef pos_i, PositionRef pos_j) 
 {
 	return (((pos_i.prev_position.y - abs(pos_i.scale.y / 2)) >= (pos_j.prev_position.y + abs(pos_j.scale.y / 2))) &&
 		((pos_i.position.y - abs(pos_i.scale.y / 2)) <= (pos_j.position.y + abs(pos_j.scale.y/2))));
 }
 
 // This function moves entity related to pos_i 'displacement' units away from entity related to pos_j
-bool collision_displace(Position& pos_i, Position& pos_j) {
+bool collision_displace(PositionRef pos_i, PositionRef pos_j) {
 	bool resolved = false;
 	if (collidedLeft(pos_i, pos_j)) {
 		float penetration = (pos_j.position.x - abs(pos_j.scale.x / 2)) - (pos_i.position.x + abs(pos_i.scale.x / 2));
@@ -944,6 +951,10 @@ void WorldSystem::handle_collisions() {
 		Entity entity = collisionsRegistry.entities[i];
 		Entity entity_other = collisionsRegistry.components[i].other_entity;
 
+		// Skip pairs with an entity already destroyed by an earlier collision this frame
+		if (registry.commands.is_destroyed(entity) || registry.commands.is_destroyed(entity_other))
+			continue;
+
 		// Checking Player - Enemy collisions
 		if (registry.enemies.has(entity_other) && registry.players.has(entity)) {
 			Enemy& enemy = registry.enemies.get(entity_other);
@@ -994,8 +1005,8 @@ void WorldSystem::handle_collisions() {
 
 		// Checking obstacle - obstacle collisions
 		if (registry.obstacles.has(entity) && registry.obstacles.has(entity_other)) {
-			Position& pos_1 = registry.positions.get(entity);
-			Position& pos_2 = registry.positions.get(entity_other);
+			PositionRef pos_1 = registry.positions.get(entity);
+			PositionRef pos_2 = registry.positions.get(entity_other);
 			Velocity& vel_1 = registry.velocities.get(entity);
 			Velocity& vel_2 = registry.velocities.get(entity_other);
 
@@ -1019,8 +1030,8 @@ void WorldSystem::handle_collisions() {
 
 		// Checking Player - Terrain Collisions
 		if (registry.players.has(entity) && registry.terrain.has(entity_other)) {
-			Position& player_position = registry.positions.get(entity);
-			Position& terrain_position = registry.positions.get(entity_other);
+			PositionRef player_position = registry.positions.patch(entity);
+			PositionRef terrain_position = registry.positions.get(entity_other);
 
 			bool resolved = collision_displace(player_position, terrain_position);
 			if (!resolved) {
@@ -1031,8 +1042,8 @@ void WorldSystem::handle_collisions() {
 		
 		// Checking Enemy - Terrain Collisions
 		if (registry.enemies.has(entity) && registry.terrain.has(entity_other)) {
-			Position& enemy_position = registry.positions.get(entity);
-			Position& terrain_position = registry.positions.get(entity_other);
+			PositionRef enemy_position = registry.positions.patch(entity);
+			PositionRef terrain_position = registry.positions.get(entity_other);
 
 			bool resolved = collision_displace(enemy_position, terrain_position);
 			if (!resolved) {
@@ -1040,36 +1051,14 @@ void WorldSystem::handle_collisions() {
 			}
 		}
 
-		// update position of entities that follow player or enemies to remove jitter
-		for (int i = 0; i < registry.followers.size(); i++) {
-			Follower& follower = registry.followers.components[i];
-			Entity entity = registry.followers.entities[i];
-			Position& position = registry.positions.get(entity);
-			Position& owner_position = registry.positions.get(follower.owner);
-			position.position = owner_position.position;
-			position.position.y += follower.y_offset;
-			position.position.x += follower.x_offset;
-		}
-
-		// 2nd phase of position correction strictly after first phase
-		for (int i = 0; i < registry.secondaryFollowers.size(); i++) {
-			SecondaryFollower& follower = registry.secondaryFollowers.components[i];
-			Entity entity = registry.secondaryFollowers.entities[i];
-			Position& position = registry.positions.get(entity);
-			Position& owner_position = registry.positions.get(follower.owner);
-			position.position = owner_position.position;
-			position.position.y += follower.y_offset;
-			position.position.x += follower.x_offset;
-		}
-
 		// Checking Moveable Terrain - Terrain Collisions
 		if (registry.terrain.has(entity) && registry.terrain.has(entity_other)) {
 			Terrain& terrain_1 = registry.terrain.get(entity);
 			// Checking if the the terrain is moveable
 			if (terrain_1.moveable) {
 				Velocity& terrain_1_velocity = registry.velocities.get(entity);
-				Position& terrain_1_position = registry.positions.get(entity);
-				Position& terrain_2_position = registry.positions.get(entity_other);
+				PositionRef terrain_1_position = registry.positions.get(entity);
+				PositionRef terrain_2_position = registry.positions.get(entity_other);
 
 				if (collidedLeft(terrain_1_position, terrain_2_position) || collidedRight(terrain_1_position, terrain_2_position)) {
 					terrain_1_velocity.velocity[0] = -terrain_1_velocity.velocity[0]; // switch x direction
@@ -1084,8 +1073,8 @@ void WorldSystem::handle_collisions() {
 				Obstacle& obstacle = registry.obstacles.get(entity);
 			
 				Velocity& obstacle_velocity = registry.velocities.get(entity);
-				Position& obstacle_position = registry.positions.get(entity);
-				Position& terrain_position = registry.positions.get(entity_other);
+				PositionRef obstacle_position = registry.positions.get(entity);
+				PositionRef terrain_position = registry.positions.get(entity_other);
 
 				if (collidedLeft(obstacle_position, terrain_position) || collidedRight(obstacle_position, terrain_position)) {
 					obstacle_velocity.velocity[0] = -obstacle_velocity.velocity[0]; // switch x direction
@@ -1099,7 +1088,7 @@ void WorldSystem::handle_collisions() {
 			if (registry.projectiles.get(entity).hostile && registry.projectiles.get(entity).type != registry.enemies.get(entity_other).type && !registry.bosses.has(entity_other)) {
 				// HEAL the target instead
 				registry.resources.get(entity_other).currentHealth += 5;
-				registry.remove_all_components_of_no_collision(entity); // delete projectile
+				registry.commands.destroy(entity); // delete projectile
 				if (registry.resources.get(entity_other).currentHealth > registry.resources.get(entity_other).maxHealth) {
 					registry.resources.get(entity_other).currentHealth = registry.resources.get(entity_other).maxHealth;
 				}
@@ -1139,7 +1128,7 @@ void WorldSystem::handle_collisions() {
 					enemy_resource.currentHealth -= damage_dealt;
 				}
 		
-				registry.remove_all_components_of_no_collision(entity); // delete projectile
+				registry.commands.destroy(entity); // delete projectile
 
 				printf("enemy hp: %f\n", enemy_resource.currentHealth);
 
@@ -1151,12 +1140,12 @@ void WorldSystem::handle_collisions() {
 						boss_position = registry.positions.get(entity_other).position; // store in case boss died so we can spawn life orb
 						Boss& boss = registry.bosses.get(entity_other);
 						if (registry.animations.has(boss.aura)) {
-							registry.remove_all_components_of(boss.aura);
+							registry.commands.destroy(boss.aura);
 						}
 					}
 
-					registry.remove_all_components_of(enemy_resource.healthBar);
-					registry.remove_all_components_of_no_collision(entity_other);
+					registry.commands.destroy(enemy_resource.healthBar);
+					registry.commands.destroy(entity_other);
 					Mix_PlayChannel(-1, enemy_death_sound, 0);
 
 					// drop a life orb shard and change background music if boss died
@@ -1200,7 +1189,7 @@ void WorldSystem::handle_collisions() {
 					if (this->curr_level.getCurrLevel() != FINAL_BOSS && !this->curr_level.getIsBossLevel()) Mix_PlayChannel(-1, aria_death_lsvl, 0);
 				}
 			}
-			registry.remove_all_components_of_no_collision(entity);
+			registry.commands.destroy(entity);
 		}
 
 		// Checking Terrain - Projectile collisions
@@ -1209,9 +1198,9 @@ void WorldSystem::handle_collisions() {
 
 			if (projectile.bounces-- > 0) {
 				// bounce the projectile off the wall
-				Position& projectile_position = registry.positions.get(entity);
+				PositionRef projectile_position = registry.positions.patch(entity);
 				Velocity& projectile_velocity = registry.velocities.get(entity);
-				Position& terrain_position = registry.positions.get(entity_other);
+				PositionRef terrain_position = registry.positions.get(entity_other);
 
 				if (collidedLeft(projectile_position, terrain_position) || collidedRight(projectile_position, terrain_position)) {
 					projectile_velocity.velocity.x *= -1;
@@ -1223,18 +1212,17 @@ void WorldSystem::handle_collisions() {
 				}
 			}
 			else {
-				registry.remove_all_components_of_no_collision(entity);
+				registry.commands.destroy(entity);
 			}
 		}
 
 		// Checking Projectile - Power Up Block collisions
 		if (registry.powerUpBlocks.has(entity_other) && registry.projectiles.has(entity)) {
 			PowerUpBlock& powerUpBlock = registry.powerUpBlocks.get(entity_other);
-			Position& blockPos = registry.positions.get(entity_other);
 
 			// do nothing if this power up is already toggled on
 			if (*powerUpBlock.powerUpToggle) {
-				registry.remove_all_components_of_no_collision(entity); // remove projectile
+				registry.commands.destroy(entity); // remove projectile
 				continue;
 			}
 
@@ -1252,7 +1240,7 @@ void WorldSystem::handle_collisions() {
 				animation.rainbow_enabled = true;
 
 				*(pub.powerUpToggle) = false;
-				registry.remove_all_components_of(pub.textEntity);
+				registry.commands.destroy(pub.textEntity);
 			}
 
 			Animation& animation = registry.animations.get(entity_other);
@@ -1266,7 +1254,7 @@ void WorldSystem::handle_collisions() {
 
 			Mix_PlayChannel(-1, power_up_sound, 0);
 
-			registry.remove_all_components_of_no_collision(entity); // remove projectile
+			registry.commands.destroy(entity); // remove projectile
 		}
 
 		// Checking Player - Exit Door collision
@@ -1285,13 +1273,13 @@ void WorldSystem::handle_collisions() {
 			player_resource.currentHealth = std::min(player_resource.maxHealth, 
 				player_resource.currentHealth + registry.healthPacks.get(entity_other).value);
 			printf("Player hp: %f\n", player_resource.currentHealth);
-			registry.remove_all_components_of_no_collision(entity_other);
+			registry.commands.destroy(entity_other);
 		}
 
 		// Player - Life Orb collision
 		if (registry.players.has(entity) && registry.lifeOrbs.has(entity_other)) {
 			// play a sound??
-			registry.remove_all_components_of_no_collision(entity_other); 
+			registry.commands.destroy(entity_other); 
 			win_level();
 		}
 
@@ -1357,7 +1345,7 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 	if (registry.deathTimers.has(player) || registry.winTimers.has(player) || (this->curr_level.getIsCutscene() && this->curr_level.curr_level != THE_END)) { return; }
 
 	Velocity& player_velocity = registry.velocities.get(player);
-	Position& player_position = registry.positions.get(player);
+	PositionRef player_position = registry.positions.patch(player);
 	Direction& player_direction = registry.directions.get(player);
 	Animation& player_animation = registry.animations.get(player);
 
@@ -1480,6 +1468,9 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 	}
 
 	// Debugging
+	if (action == GLFW_RELEASE && key == GLFW_KEY_F3) {
+		debugging.show_ai_lod = !debugging.show_ai_lod;
+	}
 	//if (key == GLFW_KEY_D) {
 	//	if (action == GLFW_RELEASE)
 	//		debugging.in_debug_mode = false;
@@ -1513,7 +1504,7 @@ void WorldSystem::on_mouse_button(int button, int action, int mod) {
 		float angle = atan2(deltaY, deltaX);
 
 		// create projectile
-		Position& position = registry.positions.get(player);
+		PositionRef position = registry.positions.get(player);
 		vec2 proj_position = position.position;
 		ElementType elementType = registry.characterProjectileTypes.get(player).projectileType; // Get current player projectile type
 
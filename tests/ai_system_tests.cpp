@@ -0,0 +1,186 @@
+// The AI's neighbour queries, LOD schedule and step cost as the enemy count grows
+#include "test.hpp"
+#include "ai_system.hpp"
+#include "world_init.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// Enemies fire into the void here, the real createProjectile needs the renderer
+Entity createProjectile(RenderSystem*, vec2, vec2, ElementType, bool, Entity&) { return Entity(); }
+
+namespace {
+	SpriteSheet enemy_sheet;
+
+	// Enemies spread evenly around the player, 150px apart on average, with the player's projectiles flying
+	// among them
+	void create_crowd(int enemies, int projectiles, std::vector<vec2>& enemy_positions, std::vector<vec2>& projectile_positions)
+	{
+		registry.clear_all_components();
+		enemy_sheet.states.assign((int)ENEMY_STATES::STATE_COUNT, AnimState(0, 0));
+		float side = std::sqrt((float)enemies) * 150.f;
+		std::mt19937 rng(enemies);
+		std::uniform_real_distribution<float> coordinate(0.f, side), speed(-300.f, 300.f);
+
+		Entity player = Entity::create();
+		registry.players.emplace(player);
+		registry.positions.emplace(player).position = { side / 2, side / 2 };
+		registry.velocities.emplace(player);
+
+		enemy_positions.clear();
+		for (int i = 0; i < enemies; i++) {
+			Entity entity = Entity::create();
+			registry.enemies.emplace(entity);
+			vec2 position = { coordinate(rng), coordinate(rng) };
+			registry.positions.emplace(entity).position = position;
+			registry.velocities.emplace(entity);
+			registry.resources.emplace(entity);
+			registry.animations.emplace(entity).sprite_sheet_ptr = &enemy_sheet;
+			enemy_positions.push_back(position);
+		}
+		projectile_positions.clear();
+		for (int i = 0; i < projectiles; i++) {
+			Entity entity = Entity::create();
+			registry.projectiles.emplace(entity).hostile = false;
+			vec2 position = { coordinate(rng), coordinate(rng) };
+			registry.positions.emplace(entity).position = position;
+			registry.velocities.emplace(entity).velocity = { speed(rng), speed(rng) };
+			projectile_positions.push_back(position);
+		}
+	}
+
+	// What the AI asks for, "points within radius of center", as a grid query and as a loop over every point
+	void within_radius(const StaticGrid& grid, const std::vector<vec2>& points, vec2 center, float radius,
+		std::vector<unsigned int>& candidates, std::vector<unsigned int>& out)
+	{
+		candidates.clear();
+		out.clear();
+		float pad = radius + 1.f;
+		grid.query({ center.x - pad, center.y - pad, center.x + pad, center.y + pad }, candidates);
+		std::sort(candidates.begin(), candidates.end());
+		for (unsigned int i : candidates) {
+			if (distance(points[i], center) < radius)
+				out.push_back(i);
+		}
+	}
+
+	void within_radius_all(const std::vector<vec2>& points, vec2 center, float radius, std::vector<unsigned int>& out)
+	{
+		out.clear();
+		for (unsigned int i = 0; i < points.size(); i++) {
+			if (distance(points[i], center) < radius)
+				out.push_back(i);
+		}
+	}
+
+	StaticGrid bake_points(const std::vector<vec2>& points)
+	{
+		std::vector<AABB> boxes;
+		for (vec2 p : points)
+			boxes.push_back({ p.x, p.y, p.x, p.y });
+		StaticGrid grid(256.f);
+		grid.bake(boxes);
+		return grid;
+	}
+}
+
+TEST(neighbour_queries_match_all_pairs)
+{
+	std::vector<vec2> enemies, projectiles;
+	create_crowd(500, 250, enemies, projectiles);
+	StaticGrid enemy_grid = bake_points(enemies), projectile_grid = bake_points(projectiles);
+	std::vector<unsigned int> candidates, found, expected;
+	for (vec2 center : enemies) {
+		// The dodge and the ally checks
+		within_radius(projectile_grid, projectiles, center, 300.f, candidates, found);
+		within_radius_all(projectiles, center, 300.f, expected);
+		CHECK(found == expected);
+		within_radius(enemy_grid, enemies, center, 250.f, candidates, found);
+		within_radius_all(enemies, center, 250.f, expected);
+		CHECK(found == expected);
+	}
+	registry.clear_all_components();
+}
+
+BENCH(ai_neighbour_queries)
+{
+	std::vector<vec2> enemies, projectiles;
+	std::vector<unsigned int> candidates, found;
+	for (int n : { 50, 500, 5000 }) {
+		create_crowd(n, n / 2, enemies, projectiles);
+		int runs = n < 5000 ? 100 : 5;
+		double all_pairs_ms = time_ms(runs, [&]() {
+			for (vec2 center : enemies) {
+				within_radius_all(projectiles, center, 300.f, found);
+				within_radius_all(enemies, center, 250.f, found);
+			}
+		});
+		double grid_ms = time_ms(runs, [&]() {
+			StaticGrid enemy_grid = bake_points(enemies), projectile_grid = bake_points(projectiles);
+			for (vec2 center : enemies) {
+				within_radius(projectile_grid, projectiles, center, 300.f, candidates, found);
+				within_radius(enemy_grid, enemies, center, 250.f, candidates, found);
+			}
+		});
+		AISystem ai;
+		double step_ms = time_ms(60, [&]() { ai.step(1000.f / 60.f); });
+		printf("  %4d enemies: queries over all pairs %.3f ms, grid %.3f ms; AISystem::step %.3f ms\n",
+			n, all_pairs_ms, grid_ms, step_ms);
+	}
+	registry.clear_all_components();
+}
+
+TEST(ai_lod_reduced_tiers_wait_a_bounded_time)
+{
+	std::vector<vec2> enemies, projectiles;
+	create_crowd(5000, 0, enemies, projectiles);
+	AISystem ai;
+	const float step_ms = 1000.f / 60.f;
+	for (int tick = 0; tick < 120; tick++)
+		ai.step(step_ms);
+
+	// More reduced tier updates fall due than a step runs, yet every enemy gets its turn within one
+	// round of the per step cap
+	size_t reduced = 0;
+	float longest_wait = 0.f;
+	for (const AILod& lod : registry.aiLods.components) {
+		reduced += lod.tier > 0;
+		longest_wait = std::max(longest_wait, lod.pending_ms);
+	}
+	CHECK(reduced > 16 * 128);
+	CHECK(longest_wait <= (reduced / 128 + 2) * step_ms);
+	registry.clear_all_components();
+}
+
+BENCH(ai_lod_steps)
+{
+	std::vector<vec2> enemies, projectiles;
+	for (int n : { 50, 500, 5000 }) {
+		// No projectiles, they would keep every enemy near one at tier 0
+		create_crowd(n, 0, enemies, projectiles);
+		AISystem ai;
+		const float step_ms = 1000.f / 60.f;
+		for (int tick = 0; tick < 64; tick++)
+			ai.step(step_ms);
+
+		double total_ms = 0., max_ms = 0.;
+		const int ticks = 120;
+		for (int tick = 0; tick < ticks; tick++) {
+			auto start = std::chrono::steady_clock::now();
+			ai.step(step_ms);
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			total_ms += ms;
+			max_ms = std::max(max_ms, ms);
+		}
+		int tiers[3] = { 0, 0, 0 };
+		float stalest_ms = 0.f;
+		for (const AILod& lod : registry.aiLods.components) {
+			tiers[lod.tier]++;
+			stalest_ms = std::max(stalest_ms, lod.pending_ms);
+		}
+		printf("  %4d enemies, tiers %d/%d/%d: step %.3f ms, slowest %.3f ms, longest wait %.0f ms\n",
+			n, tiers[0], tiers[1], tiers[2], total_ms / ticks, max_ms, stalest_ms);
+	}
+	registry.clear_all_components();
+}
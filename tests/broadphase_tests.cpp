@@ -0,0 +1,148 @@
+// The broadphase against the scalar overlaps() test and the pairwise loop it replaced
+#include "test.hpp"
+#include "broadphase.hpp"
+
+#include <cmath>
+#include <random>
+
+namespace {
+	// Boxes on a coarse integer grid so that many of them share an edge, which still counts as overlapping
+	AABBArray random_boxes(std::mt19937& rng, size_t n)
+	{
+		std::uniform_int_distribution<int> corner(0, 40), extent(0, 12);
+		AABBArray boxes;
+		for (size_t i = 0; i < n; i++) {
+			float x = (float)corner(rng), y = (float)corner(rng);
+			boxes.push_back({ x, y, x + extent(rng), y + extent(rng) });
+		}
+		return boxes;
+	}
+
+	std::vector<unsigned int> overlaps_reference(const AABB& box, const AABBArray& boxes, size_t begin, size_t end)
+	{
+		std::vector<unsigned int> hits;
+		for (size_t i = begin; i < end; i++) {
+			if (overlaps(box, { boxes.left[i], boxes.top[i], boxes.right[i], boxes.bottom[i] }))
+				hits.push_back((unsigned int)i);
+		}
+		return hits;
+	}
+}
+
+TEST(find_overlaps_matches_scalar)
+{
+	std::mt19937 rng(15);
+	std::uniform_int_distribution<int> corner(0, 40), extent(0, 12);
+	for (size_t n : { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 100, 1003 }) {
+		AABBArray boxes = random_boxes(rng, n);
+		for (int query = 0; query < 50; query++) {
+			float x = (float)corner(rng), y = (float)corner(rng);
+			AABB box = { x, y, x + extent(rng), y + extent(rng) };
+			// Ranges that start and end off the vector width too
+			size_t begin = n == 0 ? 0 : rng() % (n / 2 + 1);
+			std::vector<unsigned int> hits = { 12345 }; // results are appended
+			find_overlaps(box, boxes, begin, n, hits);
+			std::vector<unsigned int> expected = overlaps_reference(box, boxes, begin, n);
+			expected.insert(expected.begin(), 12345);
+			CHECK(hits == expected);
+		}
+	}
+}
+
+BENCH(find_overlaps_10k)
+{
+	std::mt19937 rng(15);
+	std::uniform_real_distribution<float> corner(0.f, 4000.f);
+	AABBArray boxes;
+	std::vector<AABB> queries;
+	for (int i = 0; i < 10000; i++) {
+		float x = corner(rng), y = corner(rng);
+		boxes.push_back({ x, y, x + 40.f, y + 40.f });
+		if (i % 100 == 0)
+			queries.push_back({ x, y, x + 40.f, y + 40.f });
+	}
+
+	std::vector<unsigned int> hits;
+	double vector_ms = time_ms(20, [&]() {
+		hits.clear();
+		for (const AABB& box : queries)
+			find_overlaps(box, boxes, 0, boxes.size(), hits);
+	});
+	size_t found = hits.size();
+	double scalar_ms = time_ms(20, [&]() {
+		hits.clear();
+		for (const AABB& box : queries) {
+			for (size_t i = 0; i < boxes.size(); i++) {
+				if (overlaps(box, { boxes.left[i], boxes.top[i], boxes.right[i], boxes.bottom[i] }))
+					hits.push_back((unsigned int)i);
+			}
+		}
+	});
+	CHECK(hits.size() == found);
+	printf("  %zu queries over %zu boxes: find_overlaps %.3f ms, overlaps() loop %.3f ms\n",
+		queries.size(), boxes.size(), vector_ms, scalar_ms);
+}
+
+namespace {
+	std::vector<std::pair<unsigned int, unsigned int>> pairs_reference(const std::vector<AABB>& boxes)
+	{
+		std::vector<std::pair<unsigned int, unsigned int>> pairs;
+		for (unsigned int i = 0; i < boxes.size(); i++) {
+			for (unsigned int j = i + 1; j < boxes.size(); j++) {
+				if (overlaps(boxes[i], boxes[j]))
+					pairs.emplace_back(i, j);
+			}
+		}
+		return pairs;
+	}
+
+	// n bodies of 40x40 spread so that each overlaps a few others, like a crowded level
+	std::vector<AABB> crowd(std::mt19937& rng, size_t n)
+	{
+		std::uniform_real_distribution<float> corner(0.f, 120.f * std::sqrt((float)n));
+		std::vector<AABB> boxes;
+		for (size_t i = 0; i < n; i++) {
+			float x = corner(rng), y = corner(rng);
+			boxes.push_back({ x, y, x + 40.f, y + 40.f });
+		}
+		return boxes;
+	}
+}
+
+TEST(spatial_hash_matches_pairwise)
+{
+	std::mt19937 rng(12);
+	std::uniform_real_distribution<float> corner(-500.f, 3000.f), extent(1.f, 150.f);
+	SpatialHash hash;
+	for (int round = 0; round < 100; round++) {
+		std::vector<AABB> boxes;
+		size_t n = rng() % 400;
+		for (size_t i = 0; i < n; i++) {
+			float x = corner(rng), y = corner(rng), width = extent(rng);
+			if (rng() % 30 == 0)
+				width = 3000.f; // a wall too long for the grid
+			else if (rng() % 10 == 0)
+				width = 0.f;
+			boxes.push_back({ x, y, x + width, y + extent(rng) });
+		}
+		// Touching corners overlap, and the cell holding the corner reports them
+		if (n > 1)
+			boxes[1] = { boxes[0].right, boxes[0].bottom, boxes[0].right + 10.f, boxes[0].bottom + 10.f };
+		hash.build(boxes);
+		CHECK(hash.pairs() == pairs_reference(boxes));
+	}
+}
+
+BENCH(spatial_hash_vs_pairwise)
+{
+	std::mt19937 rng(12);
+	SpatialHash hash;
+	for (size_t n : { 100, 1000, 10000 }) {
+		std::vector<AABB> boxes = crowd(rng, n);
+		double hash_ms = time_ms(n < 10000 ? 100 : 20, [&]() { hash.build(boxes); });
+		size_t pairs = 0;
+		double pairwise_ms = time_ms(n < 10000 ? 10 : 1, [&]() { pairs = pairs_reference(boxes).size(); });
+		CHECK(hash.pairs().size() == pairs);
+		printf("  %5zu bodies, %zu pairs: spatial hash %.3f ms, pairwise %.3f ms\n", n, pairs, hash_ms, pairwise_ms);
+	}
+}
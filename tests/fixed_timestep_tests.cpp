@@ -0,0 +1,48 @@
+// The tick count of the fixed timestep loop, with the tick rate changed at runtime
+#include "test.hpp"
+#include "fixed_timestep.hpp"
+
+TEST(fixed_timestep_counts_ticks)
+{
+	// Tick lengths that are exact in float, so the leftovers are too
+	FixedTimestep timestep(16.f, 5);
+	CHECK(timestep.advance(10.f) == 0);
+	CHECK(timestep.advance(10.f) == 1);
+	CHECK(timestep.alpha() == 0.25f);
+	CHECK(timestep.advance(44.f) == 3);
+	CHECK(timestep.alpha() == 0.f);
+
+	// At the catch-up limit the remaining whole ticks are dropped, the fraction is kept
+	CHECK(timestep.advance(200.f) == 5);
+	CHECK(timestep.alpha() == 0.5f);
+	CHECK(timestep.advance(8.f) == 1);
+}
+
+TEST(fixed_timestep_follows_rate_changes)
+{
+	FixedTimestep timestep(16.f, 5);
+	CHECK(timestep.advance(24.f) == 1);
+
+	// The 8 ms left over are one whole tick at twice the rate
+	timestep.setTickMs(8.f);
+	CHECK(timestep.alpha() == 1.f);
+	CHECK(timestep.advance(0.f) == 1);
+	CHECK(timestep.advance(36.f) == 4);
+	CHECK(timestep.alpha() == 0.5f);
+
+	// Slower ticks: the 4 ms left over aren't enough for one
+	timestep.setRate(31.25f);
+	CHECK(timestep.tickMs() == 32.f);
+	CHECK(timestep.advance(20.f) == 0);
+	CHECK(timestep.advance(8.f) == 1);
+
+	// A higher rate runs into the catch-up limit sooner, a raised limit catches up again
+	timestep.setTickMs(4.f);
+	CHECK(timestep.advance(40.f) == 5);
+	CHECK(timestep.alpha() == 0.f);
+	timestep.setMaxTicksPerFrame(10);
+	CHECK(timestep.advance(40.f) == 10);
+
+	timestep.reset();
+	CHECK(timestep.advance(3.f) == 0);
+}
@@ -0,0 +1,40 @@
+// Runs the tests, or with "bench [name]" the benchmarks whose name contains 'name'
+#include "test.hpp"
+
+#include <cstring>
+
+int check_failures = 0;
+
+std::vector<TestCase>& tests()
+{
+	static std::vector<TestCase> list;
+	return list;
+}
+
+std::vector<TestCase>& benches()
+{
+	static std::vector<TestCase> list;
+	return list;
+}
+
+int main(int argc, char* argv[])
+{
+	bool bench = argc > 1 && strcmp(argv[1], "bench") == 0;
+	const char* filter = argc > (bench ? 2 : 1) ? argv[bench ? 2 : 1] : "";
+
+	int failed = 0;
+	for (const TestCase& test : bench ? benches() : tests()) {
+		if (strstr(test.name, filter) == nullptr)
+			continue;
+		printf("%s\n", test.name);
+		int failures = check_failures;
+		test.run();
+		if (check_failures != failures) {
+			printf("  FAILED\n");
+			failed++;
+		}
+	}
+	if (!bench)
+		printf("%d of %zu tests failed\n", failed, tests().size());
+	return failed == 0 ? 0 : 1;
+}
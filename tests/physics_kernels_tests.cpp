@@ -0,0 +1,124 @@
+// The physics kernels against the plain libm code they replaced
+#include "test.hpp"
+#include "physics_kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+	const float WINDOW_WIDTH = 1200.f, WINDOW_HEIGHT = 800.f;
+	const float LIGHT_RADIUS = 0.7f, MAX_DIST = LIGHT_RADIUS * WINDOW_WIDTH;
+
+	ShadowBatch random_shadows(std::mt19937& rng, size_t n)
+	{
+		std::uniform_real_distribution<float> coordinate(-2000.f, 2000.f), scale(10.f, 100.f);
+		ShadowBatch batch;
+		for (size_t i = 0; i < n; i++)
+			batch.push_back(coordinate(rng), coordinate(rng), scale(rng), scale(rng), coordinate(rng), coordinate(rng));
+		return batch;
+	}
+}
+
+TEST(approx_atan2_accuracy)
+{
+	std::mt19937 rng(21);
+	std::uniform_real_distribution<float> coordinate(-2000.f, 2000.f);
+	float max_error = 0.f;
+	for (int i = 0; i < 1000000; i++) {
+		float y = coordinate(rng), x = coordinate(rng);
+		max_error = std::max(max_error, std::fabs(approx_atan2(y, x) - std::atan2(y, x)));
+	}
+	CHECK(max_error < 1e-5f);
+	// The axes and the origin, where the octant folding meets
+	for (float y : { -1.f, 0.f, 1.f }) {
+		for (float x : { -1.f, 0.f, 1.f })
+			CHECK(std::fabs(approx_atan2(y, x) - std::atan2(y, x)) < 1e-5f);
+	}
+}
+
+TEST(shadow_kernel_matches_reference)
+{
+	std::mt19937 rng(21);
+	const float light_x = 300.f, light_y = 400.f;
+	// Sizes that leave an SSE2 tail, and a shadow right on top of the light
+	for (size_t n : { 0, 1, 3, 4, 5, 7, 10001 }) {
+		ShadowBatch batch = random_shadows(rng, n);
+		batch.push_back(light_x, light_y, 50.f, 50.f, light_x, light_y);
+		shadow_kernel(batch, light_x, light_y, WINDOW_WIDTH, WINDOW_HEIGHT, LIGHT_RADIUS, MAX_DIST);
+
+		for (size_t i = 0; i < batch.size(); i++) {
+			// What the physics system computed per shadow before the kernel
+			float owner_x = batch.owner_x[i], owner_y = batch.owner_y[i];
+			bool active = !(std::hypot((batch.shadow_x[i] - light_x) / WINDOW_WIDTH, (batch.shadow_y[i] - light_y) / WINDOW_HEIGHT) > LIGHT_RADIUS);
+			float angle = std::atan2(owner_y - light_y, owner_x - light_x) + (float)M_PI / 2;
+			float dist = std::hypot(owner_x - light_x, owner_y - light_y);
+			float scale_x = batch.owner_scale_x[i] * (MAX_DIST - dist) / MAX_DIST;
+			float scale_y = batch.owner_scale_y[i] * (MAX_DIST - dist) / MAX_DIST * 1.5f;
+			float x = owner_x + std::cos(angle - (float)M_PI / 2) * (scale_y / 2);
+			float y = owner_y + batch.owner_scale_y[i] / 2 + scale_y / 2 * std::sin(angle - (float)M_PI / 2);
+
+			CHECK(active == (batch.active[i] != 0.f));
+			CHECK(std::fabs(angle - batch.angle[i]) < 1e-4f);
+			CHECK(std::fabs(scale_x - batch.scale_x[i]) < 1e-3f && std::fabs(scale_y - batch.scale_y[i]) < 1e-3f);
+			CHECK(std::fabs(x - batch.x[i]) < 1e-2f && std::fabs(y - batch.y[i]) < 1e-2f);
+		}
+	}
+}
+
+TEST(integrate_kernel_matches_reference)
+{
+	std::mt19937 rng(21);
+	std::uniform_real_distribution<float> coordinate(-2000.f, 2000.f);
+	const size_t n = 1001;
+	const float step_seconds = 1 / 60.f;
+	std::vector<vec2> positions(n);
+	std::vector<Velocity> velocities(n);
+	std::vector<float> awake(n);
+	for (size_t i = 0; i < n; i++) {
+		positions[i] = { coordinate(rng), coordinate(rng) };
+		velocities[i].velocity = { coordinate(rng), coordinate(rng) };
+		awake[i] = i % 7 == 0 ? 0.f : 1.f;
+	}
+	std::vector<vec2> expected = positions;
+	for (size_t i = 0; i < n; i++)
+		expected[i] += step_seconds * awake[i] * velocities[i].velocity;
+
+	integrate_kernel(positions.data(), velocities.data(), awake.data(), step_seconds, n);
+	for (size_t i = 0; i < n; i++) {
+		// Same operations in the same order, so bit for bit the same
+		CHECK(positions[i] == expected[i]);
+	}
+}
+
+BENCH(physics_kernels_10k)
+{
+	std::mt19937 rng(21);
+	const size_t n = 10000;
+	const float light_x = 300.f, light_y = 400.f;
+	ShadowBatch batch = random_shadows(rng, n);
+	double kernel_ms = time_ms(200, [&]() {
+		shadow_kernel(batch, light_x, light_y, WINDOW_WIDTH, WINDOW_HEIGHT, LIGHT_RADIUS, MAX_DIST);
+	});
+	volatile float sink = 0.f;
+	double libm_ms = time_ms(200, [&]() {
+		float sum = 0.f;
+		for (size_t i = 0; i < n; i++) {
+			float angle = std::atan2(batch.owner_y[i] - light_y, batch.owner_x[i] - light_x);
+			sum += std::cos(angle) + std::sin(angle);
+		}
+		sink = sum;
+	});
+	printf("  %zu shadows: shadow_kernel %.3f ms, atan2/cos/sin alone %.3f ms\n", n, kernel_ms, libm_ms);
+
+	std::uniform_real_distribution<float> coordinate(-2000.f, 2000.f);
+	std::vector<vec2> positions(n);
+	std::vector<Velocity> velocities(n);
+	std::vector<float> awake(n, 1.f);
+	for (size_t i = 0; i < n; i++)
+		velocities[i].velocity = { coordinate(rng), coordinate(rng) };
+	double integrate_ms = time_ms(200, [&]() {
+		integrate_kernel(positions.data(), velocities.data(), awake.data(), 1 / 60.f, n);
+	});
+	printf("  %zu bodies: integrate_kernel %.3f ms\n", n, integrate_ms);
+}
@@ -0,0 +1,184 @@
+// The physics step on a bullet-heavy boss scene, run on worker pools of different sizes
+#include "test.hpp"
+#include "physics_system.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace {
+	Mesh square, octagon;
+	// Body number of each entity index, so runs that got different entity ids hash the same
+	std::vector<unsigned int> body_of;
+	unsigned int bodies = 0;
+
+	Entity create_body(vec2 position, vec2 velocity, vec2 scale, Mesh* mesh, uint32_t category, uint32_t mask, bool continuous)
+	{
+		Entity entity = Entity::create();
+		PositionRef pos = registry.positions.emplace(entity);
+		pos.position = pos.prev_position = position;
+		pos.scale = scale;
+		pos.angle = std::atan2(velocity.y, velocity.x);
+		registry.velocities.emplace(entity).velocity = velocity;
+		Collidable& collidable = registry.collidables.emplace(entity);
+		collidable.category = category;
+		collidable.mask = mask;
+		collidable.continuous = continuous;
+		registry.meshPtrs.emplace(entity, mesh);
+		if (body_of.size() <= entity.index())
+			body_of.resize(entity.index() + 1);
+		body_of[entity.index()] = bodies++;
+		return entity;
+	}
+
+	// The player and a boss in a walled arena, with rings of bullets flying out of the boss
+	void create_boss_scene(int bullets)
+	{
+		registry.clear_all_components();
+		body_of.clear();
+		bodies = 0;
+		vec2 corners[4] = { { -.5f, -.5f }, { .5f, -.5f }, { .5f, .5f }, { -.5f, .5f } };
+		square.vertices.resize(4);
+		for (int i = 0; i < 4; i++)
+			square.vertices[i].position = { corners[i].x, corners[i].y, 0.f };
+		octagon.vertices.resize(8);
+		for (int i = 0; i < 8; i++)
+			octagon.vertices[i].position = { 0.5f * std::cos(i * 0.785f), 0.5f * std::sin(i * 0.785f), 0.f };
+
+		Entity player = create_body({ 0.f, 300.f }, { 0.f, 0.f }, { 60.f, 100.f }, &octagon, CATEGORY_PLAYER,
+			CATEGORY_ENEMY | CATEGORY_ENEMY_PROJECTILE | CATEGORY_TERRAIN | CATEGORY_BOSS, false);
+		registry.players.emplace(player);
+		create_body({ 0.f, 0.f }, { 0.f, 0.f }, { 200.f, 200.f }, &octagon, CATEGORY_BOSS,
+			CATEGORY_PLAYER | CATEGORY_TERRAIN | CATEGORY_PLAYER_PROJECTILE, false);
+		for (int side = 0; side < 4; side++) {
+			vec2 center = side == 0 ? vec2(0.f, -700.f) : side == 1 ? vec2(0.f, 700.f) : side == 2 ? vec2(-700.f, 0.f) : vec2(700.f, 0.f);
+			vec2 scale = side < 2 ? vec2(1425.f, 25.f) : vec2(25.f, 1425.f);
+			Entity wall = create_body(center, { 0.f, 0.f }, scale, &square, CATEGORY_TERRAIN,
+				CATEGORY_PLAYER | CATEGORY_ENEMY_PROJECTILE | CATEGORY_PLAYER_PROJECTILE | CATEGORY_BOSS, false);
+			registry.terrain.emplace(wall);
+			registry.velocities.remove(wall);
+		}
+
+		std::mt19937 rng(20);
+		std::uniform_real_distribution<float> unit(-1.f, 1.f);
+		for (int i = 0; i < bullets; i++) {
+			float angle = unit(rng) * 3.14159f, dist = 100.f + 300.f * (unit(rng) + 1.f);
+			vec2 direction = { std::cos(angle), std::sin(angle) };
+			bool hostile = i % 8 != 0;
+			uint32_t mask = (hostile ? CATEGORY_PLAYER : CATEGORY_BOSS) | CATEGORY_TERRAIN | CATEGORY_PLAYER_PROJECTILE | CATEGORY_ENEMY_PROJECTILE;
+			create_body(direction * dist, direction * 500.f, { 40.f, 40.f }, &octagon,
+				hostile ? CATEGORY_ENEMY_PROJECTILE : CATEGORY_PLAYER_PROJECTILE, mask, true);
+		}
+	}
+
+	// Steps the scene with the given number of threads, returns a hash of every collision in order
+	uint64_t run_boss_scene(unsigned int threads, int bullets, int ticks, double& ms_per_tick, size_t& collisions)
+	{
+		create_boss_scene(bullets);
+		PhysicsSystem physics(threads);
+		uint64_t hash = 1469598103934665603ull;
+		double total_ms = 0.;
+		collisions = 0;
+		for (int tick = 0; tick < ticks; tick++) {
+			physics.beginTick();
+			auto start = std::chrono::steady_clock::now();
+			physics.step(16.f);
+			total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			for (size_t i = 0; i < registry.collisions.size(); i++) {
+				const Collision& collision = registry.collisions.components[i];
+				unsigned int record[4] = { body_of[registry.collisions.entities[i].index()], body_of[collision.other_entity.index()] };
+				memcpy(&record[2], &collision.displacement, sizeof(float) * 2);
+				for (size_t byte = 0; byte < sizeof(record); byte++) {
+					hash ^= ((const unsigned char*)record)[byte];
+					hash *= 1099511628211ull;
+				}
+			}
+			collisions += registry.collisions.size();
+			registry.collisions.clear();
+			physics.endTick();
+		}
+		ms_per_tick = total_ms / ticks;
+		registry.clear_all_components();
+		return hash;
+	}
+}
+
+TEST(narrowphase_same_for_any_thread_count)
+{
+	double ms;
+	size_t collisions, serial_collisions;
+	uint64_t serial = run_boss_scene(1, 1000, 10, ms, serial_collisions);
+	CHECK(serial_collisions > 0);
+	for (unsigned int threads : { 2, 4, 8 }) {
+		CHECK(run_boss_scene(threads, 1000, 10, ms, collisions) == serial);
+		CHECK(collisions == serial_collisions);
+	}
+}
+
+BENCH(narrowphase_threads)
+{
+	printf("  6000 bullets over 20 ticks, %u hardware threads\n", std::thread::hardware_concurrency());
+	for (unsigned int threads : { 1, 2, 4, 8 }) {
+		double ms;
+		size_t collisions;
+		uint64_t hash = run_boss_scene(threads, 6000, 20, ms, collisions);
+		printf("  %u threads: step %.3f ms/tick, %zu collisions, hash %016llx\n", threads, ms, collisions, (unsigned long long)hash);
+	}
+}
+
+TEST(transform_cycle_is_detached)
+{
+	registry.clear_all_components();
+	// a -> b -> c -> a, with d hanging below a and e a plain child of d
+	Entity a = Entity::create(), b = Entity::create(), c = Entity::create(), d = Entity::create(), e = Entity::create();
+	for (Entity entity : { a, b, c, d, e })
+		registry.positions.emplace(entity).position = { 1.f, 1.f };
+	registry.parents.emplace(a) = { b, { 10.f, 0.f } };
+	registry.parents.emplace(b) = { c, { 10.f, 0.f } };
+	registry.parents.emplace(c) = { a, { 10.f, 0.f } };
+	registry.parents.emplace(d) = { a, { 0.f, 10.f } };
+	registry.parents.emplace(e) = { d, { 0.f, 10.f } };
+
+	PhysicsSystem physics(1);
+	physics.propagateTransforms();
+	// Exactly one link of the cycle is cut, the children below it still follow
+	CHECK(registry.parents.size() == 4);
+	CHECK(registry.parents.has(d) && registry.parents.has(e));
+	CHECK(registry.positions.get(d).position == registry.positions.get(a).position + vec2(0.f, 10.f));
+	CHECK(registry.positions.get(e).position == registry.positions.get(d).position + vec2(0.f, 10.f));
+	registry.clear_all_components();
+}
+
+TEST(position_fields_follow_the_movers_group)
+{
+	registry.clear_all_components();
+	typedef soa_layout<Position> P;
+	std::vector<Entity> entities;
+	for (int i = 0; i < 64; i++) {
+		Entity entity = Entity::create();
+		registry.positions.insert(entity, { vec2(i, -i), 0.1f * i, vec2(i + 1), vec2(i, -i) });
+		// Every other body moves, so the group swaps it to the front of the position arrays
+		if (i % 2)
+			registry.velocities.emplace(entity).velocity = { 1.f, 0.f };
+		entities.push_back(entity);
+	}
+	for (int i = 0; i < 64; i += 5)
+		registry.remove_all_components_of(entities[i]);
+
+	auto position = registry.positions.field<P::POSITION>();
+	auto angle = registry.positions.field<P::ANGLE>();
+	auto scale = registry.positions.field<P::SCALE>();
+	CHECK(position.size == registry.positions.size());
+	for (int i = 0; i < 64; i++) {
+		if (i % 5 == 0) {
+			CHECK(!registry.positions.has(entities[i]));
+			continue;
+		}
+		unsigned int k = registry.positions.index_of(entities[i]);
+		CHECK(position[k] == vec2(i, -i) && angle[k] == 0.1f * i && scale[k] == vec2(i + 1));
+		CHECK(registry.movers.contains(entities[i]) == (i % 2 == 1));
+		CHECK(!registry.movers.contains(entities[i]) || k < registry.movers.size());
+	}
+	registry.clear_all_components();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// A tiny test and benchmark harness, see main.cpp. TEST(name) and BENCH(name) define a function and register it
+// before main runs, CHECK reports a failure and carries on with the test.
+struct TestCase {
+	const char* name;
+	void (*run)();
+};
+
+std::vector<TestCase>& tests();
+std::vector<TestCase>& benches();
+extern int check_failures;
+
+struct TestRegistration {
+	TestRegistration(std::vector<TestCase>& list, const char* name, void (*run)()) { list.push_back({ name, run }); }
+};
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistration name##_registration(tests(), #name, name); \
+	static void name()
+
+#define BENCH(name) \
+	static void name(); \
+	static TestRegistration name##_registration(benches(), #name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			check_failures++; \
+		} \
+	} while (0)
+
+// Average milliseconds per call of f over 'runs' calls, after one warm-up call
+template <class F>
+double time_ms(int runs, F f)
+{
+	f();
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < runs; i++)
+		f();
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count() / runs;
+}
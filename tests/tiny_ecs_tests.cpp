@@ -0,0 +1,48 @@
+// The deferred structural changes of the command buffer
+#include "test.hpp"
+#include "tiny_ecs_registry.hpp"
+
+TEST(command_buffer_applies_in_recording_order)
+{
+	registry.clear_all_components();
+	std::vector<Entity> entities;
+	for (int i = 0; i < 16; i++) {
+		Entity entity = Entity::create();
+		registry.positions.emplace(entity).position = { (float)i, 0.f };
+		registry.directions.emplace(entity);
+		entities.push_back(entity);
+	}
+
+	// Applied right away, for the order a flush has to reproduce
+	ComponentContainer<Direction> expected;
+	for (Entity entity : entities)
+		expected.emplace(entity);
+	for (int i : { 3, 11, 0, 7, 2 })
+		expected.remove(entities[i]);
+
+	// Interleaved with removals from another container, which the flush groups apart
+	for (int i : { 3, 11, 0, 7 }) {
+		registry.commands.remove(registry.directions, entities[i]);
+		registry.commands.remove(registry.positions, entities[15 - i]);
+	}
+	// Inserted once, skipped for an entity that has one by then or is destroyed in the same flush
+	registry.commands.insert(registry.velocities, entities[1], Velocity{ { 1.f, 0.f } });
+	registry.commands.insert(registry.velocities, entities[1], Velocity{ { 2.f, 0.f } });
+	registry.commands.insert(registry.directions, entities[5], Direction());
+	registry.commands.insert(registry.velocities, entities[2], Velocity());
+	registry.commands.destroy(entities[2]);
+	CHECK(!registry.commands.empty());
+	registry.flush_commands();
+	CHECK(registry.commands.empty());
+
+	CHECK(registry.directions.entities == expected.entities);
+	CHECK(registry.positions.size() == 11);
+	CHECK(registry.velocities.size() == 1 && registry.velocities.get(entities[1]).velocity.x == 1.f);
+	CHECK(!Entity::alive(entities[2]));
+
+	// The queues are reused, a second round gives the same result
+	registry.commands.insert(registry.velocities, entities[6], Velocity{ { 3.f, 0.f } });
+	registry.flush_commands();
+	CHECK(registry.velocities.size() == 2 && registry.velocities.get(entities[6]).velocity.x == 3.f);
+	registry.clear_all_components();
+}